@@ -0,0 +1,160 @@
+/**
+ * @file DecodedTextureCache.cpp
+ * @brief Écriture et relecture des fichiers .r3dt du cache de textures décodées.
+ */
+
+#include "DecodedTextureCache.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace Render3D;
+
+namespace
+{
+    constexpr char DecodedMagic[4] = { 'R', '3', 'D', 'T' };
+    constexpr uint32_t DecodedVersion = 1;
+    constexpr size_t DecodedAlignment = 64;
+    constexpr uint32_t DecodedChannels = 3;
+
+    struct DecodedHeader
+    {
+        char magic[4];
+        uint32_t version;
+        SourceStamp source;
+        uint32_t level;
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint64_t pixels;       // offset des pixels (aligné sur 64 octets)
+        uint64_t pixelsSize;   // width * height * channels
+        uint32_t keyLength;    // chemin canonique du JPEG, à la suite de l'en-tête
+        uint32_t padding;
+    };
+
+    string LevelSuffix(int level)
+    {
+        return "-" + to_string(level) + ".r3dt";
+    }
+}
+
+string Render3D::TextureSourceKey(const string& path)
+{
+    // Chemin canonique : deux chemins (relatifs, liens symboliques) vers le même fichier partagent l'entrée.
+    error_code ec;
+    const filesystem::path canonical = filesystem::weakly_canonical(path, ec);
+    return ec ? path : canonical.string();
+}
+
+string Render3D::TextureEntryPath(const string& directory, const string& key, const string& suffix)
+{
+    char hash[20];
+    snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(HashBytes(key.data(), key.size())));
+    return (filesystem::path(directory) / (hash + suffix)).string();
+}
+
+string Render3D::DecodedTextureCacheDirectory()
+{
+    const char* env = std::getenv("R3D_TEXTURE_CACHE");
+    if (env != nullptr)
+        return strcmp(env, "0") == 0 ? string() : string(env);
+    error_code ec;
+    const filesystem::path temp = filesystem::temp_directory_path(ec);
+    return ec ? string() : (temp / "render3d-textures").string();
+}
+
+bool Render3D::LoadDecodedTexture(const string& path, int level, TextureImage& image)
+{
+    const string directory = DecodedTextureCacheDirectory();
+    if (directory.empty() || path.empty())
+        return false;
+
+    const string key = TextureSourceKey(path);
+    // Texture échantillonnée partout dans l'image : toutes les pages sont lues dès la projection.
+    MappedFile file(TextureEntryPath(directory, key, LevelSuffix(level)), true);
+    if (!file.is_open() || file.size() < sizeof(DecodedHeader))
+        return false;
+
+    DecodedHeader header;
+    memcpy(&header, file.data(), sizeof(DecodedHeader));
+    const uint64_t size = file.size();
+    if (memcmp(header.magic, DecodedMagic, sizeof(DecodedMagic)) != 0 || header.version != DecodedVersion ||
+        header.level != static_cast<uint32_t>(level) || header.channels != DecodedChannels ||
+        header.keyLength > size - sizeof(DecodedHeader) ||
+        key.compare(0, string::npos, file.data() + sizeof(DecodedHeader), header.keyLength) != 0 ||
+        header.pixelsSize != static_cast<uint64_t>(header.width) * header.height * DecodedChannels ||
+        header.pixels % DecodedAlignment != 0 || header.pixels > size || header.pixelsSize > size - header.pixels)
+        return false;
+
+    // JPEG modifié depuis l'écriture de l'entrée : elle sera remplacée après le décodage.
+    if (!SameSource(header.source, path))
+        return false;
+
+    image.pixels = reinterpret_cast<const unsigned char*>(file.data() + header.pixels);
+    image.mapping = std::move(file);
+    image.decoded.reset();
+    image.width = static_cast<int>(header.width);
+    image.height = static_cast<int>(header.height);
+    image.level = level;
+    image.loaded = true;
+    return true;
+}
+
+void Render3D::SaveDecodedTexture(const string& path, const SourceStamp& source, const TextureImage& image)
+{
+    const string directory = DecodedTextureCacheDirectory();
+    if (directory.empty() || !image.loaded || !source.exists)
+        return;
+
+    error_code ec;
+    filesystem::create_directories(directory, ec);
+
+    // Nom temporaire propre à l'écrivain : deux processus qui décodent la même texture n'écrivent pas
+    // dans le même fichier, et le renommage final remplace l'entrée d'un seul coup.
+    const string key = TextureSourceKey(path);
+    const string entryPath = TextureEntryPath(directory, key, LevelSuffix(image.level));
+    const string tmpPath = entryPath + "." + to_string(random_device{}()) + ".tmp";
+    ofstream out(tmpPath, ios::binary | ios::trunc);
+    if (!out)
+    {
+        cerr << "Texture cache not written: cannot write " << tmpPath << endl;
+        return;
+    }
+
+    DecodedHeader header{};
+    memcpy(header.magic, DecodedMagic, sizeof(DecodedMagic));
+    header.version = DecodedVersion;
+    header.source = source;
+    header.level = static_cast<uint32_t>(image.level);
+    header.width = static_cast<uint32_t>(image.width);
+    header.height = static_cast<uint32_t>(image.height);
+    header.channels = DecodedChannels;
+    header.keyLength = static_cast<uint32_t>(key.size());
+    header.pixels = (sizeof(DecodedHeader) + key.size() + DecodedAlignment - 1) / DecodedAlignment * DecodedAlignment;
+    header.pixelsSize = static_cast<uint64_t>(image.width) * image.height * DecodedChannels;
+
+    const char zeros[DecodedAlignment] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(key.data(), static_cast<streamsize>(key.size()));
+    out.write(zeros, static_cast<streamsize>(header.pixels - sizeof(header) - key.size()));
+    out.write(reinterpret_cast<const char*>(image.pixels), static_cast<streamsize>(header.pixelsSize));
+    out.close();
+
+    if (!out)
+    {
+        cerr << "Texture cache not written: cannot write " << tmpPath << endl;
+        filesystem::remove(tmpPath, ec);
+        return;
+    }
+    filesystem::rename(tmpPath, entryPath, ec);
+    if (ec)
+    {
+        cerr << "Texture cache not written: " << ec.message() << endl;
+        filesystem::remove(tmpPath, ec);
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * @file DecodedTextureCache.hpp
+ * @brief Cache sur disque (.r3dt) des textures décodées, relu par projection mémoire sans décodage JPEG.
+ *
+ * Chaque niveau de résolution décodé d'un JPEG est écrit dans un fichier du dossier de cache :
+ * un en-tête versionné (identité du JPEG source, niveau, dimensions) suivi des pixels RGB bruts,
+ * alignés sur 64 octets et rangés comme TextureImage les attend. Aux exécutions suivantes,
+ * l'image est projetée en mémoire et utilisée telle quelle par les textures.
+ *
+ * Le nom du fichier dérive du chemin du JPEG et du niveau ; l'entrée est valide tant que le JPEG
+ * garde sa taille et sa date de modification, ou à défaut son empreinte de contenu.
+ * Le dossier peut être vidé à tout moment : les textures sont alors décodées à nouveau.
+ */
+
+#ifndef DecodedTextureCache_hpp
+#define DecodedTextureCache_hpp
+
+#include <string>
+#include "MeshCache.hpp"
+#include "TextureCache.hpp"
+
+using namespace std;
+
+namespace Render3D
+{
+    /**
+     * @brief Dossier du cache de textures décodées
+     * @return Le dossier, ou une chaîne vide si le cache est désactivé
+     *
+     * Lu dans R3D_TEXTURE_CACHE (R3D_TEXTURE_CACHE=0 désactive le cache) ; par défaut,
+     * render3d-textures dans le dossier temporaire du système. Plusieurs processus peuvent
+     * partager le même dossier (ferme de rendu) : un fichier n'y apparaît qu'une fois entièrement écrit.
+     */
+    string DecodedTextureCacheDirectory();
+
+    /**
+     * @brief Clé d'un JPEG dans le cache : son chemin canonique
+     */
+    string TextureSourceKey(const string& path);
+
+    /**
+     * @brief Chemin d'une entrée du cache : empreinte de la clé suivie d'un suffixe (niveau, extension)
+     */
+    string TextureEntryPath(const string& directory, const string& key, const string& suffix);
+
+    /**
+     * @brief Charge une texture décodée depuis le cache
+     * @param path Chemin du fichier JPEG source
+     * @param level Niveau de résolution (0 : pleine résolution)
+     * @param image Image à remplir ; ses pixels pointent dans la projection du fichier de cache
+     * @return true si une entrée valide existe ; false sinon (image inchangée)
+     */
+    bool LoadDecodedTexture(const string& path, int level, TextureImage& image);
+
+    /**
+     * @brief Écrit une texture qui vient d'être décodée dans le cache
+     * @param path Chemin du fichier JPEG source
+     * @param source Relevé du JPEG (avec empreinte) pris avant son décodage
+     * @param image Image décodée
+     *
+     * Un échec d'écriture (dossier en lecture seule, disque plein...) est signalé sans interrompre le rendu.
+     */
+    void SaveDecodedTexture(const string& path, const SourceStamp& source, const TextureImage& image);
+};
+#endif /* DecodedTextureCache_hpp */
@@ -11,146 +11,613 @@
 
 
 #include "LoadObj.hpp"
+#include "MeshStream.hpp"
+#include "../Tools/MappedFile.hpp"
 #include "string.h"
 #include <stdlib.h>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <charconv>
+#include <string_view>
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <cfloat>
+#include <climits>
+#include <filesystem>
+#include <fstream>
 using namespace std;
 using namespace Render3D;
 
-/**
- * @brief Constructeur de la classe LoadObj
- * @param path Chemin du fichier OBJ à charger
- */
-LoadObj::LoadObj(string path)
+namespace
 {
-    _path = path;
-    string line;
-    _tmpMeshes.push_back(TmpMesh());
-    verticesCount = 0;
-    facesCount = 0;
-    _ns = 0.0f;
-    _ka = {};
-    _kd = {};
-    _ks = {};
-    _ke = {};
-    int nbObjects = 0, iTmp = 0;
+    inline bool IsBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
 
-    try {
-        ifstream file(strdup(path.c_str()));
-        string prefix, tmp;
-        while (getline(file, line))
+    inline const char* SkipBlanks(const char* p, const char* end)
+    {
+        while (p < end && IsBlank(*p))
+            ++p;
+        return p;
+    }
+
+    inline const char* TokenEnd(const char* p, const char* end)
+    {
+        while (p < end && !IsBlank(*p))
+            ++p;
+        return p;
+    }
+
+    // Mot suivant de la ligne (vide s'il n'y en a plus), sans allocation.
+    inline string_view NextToken(const char*& p, const char* end)
+    {
+        const char* first = SkipBlanks(p, end);
+        p = TokenEnd(first, end);
+        return string_view(first, static_cast<size_t>(p - first));
+    }
+
+    template<typename T>
+    inline const char* ParseNumber(const char* p, const char* end, T& out)
+    {
+        p = SkipBlanks(p, end);
+        if (p < end && *p == '+') // accepté par istream, pas par from_chars
+            ++p;
+        auto result = from_chars(p, end, out);
+        if (result.ec != errc())
+            throw std::runtime_error("Invalid number in OBJ file: " + string(p, TokenEnd(p, end)));
+        return result.ptr;
+    }
+
+    inline const char* ParseVec3(const char* p, const char* end, vec3& out)
+    {
+        p = ParseNumber(p, end, out.x);
+        p = ParseNumber(p, end, out.y);
+        return ParseNumber(p, end, out.z);
+    }
+
+    // Indice du matériau dans la table de l'objet, ajouté à sa première utilisation.
+    uint16_t InternMaterial(TmpMesh& mesh, const string& name)
+    {
+        auto found = find(mesh.materialNames.begin(), mesh.materialNames.end(), name);
+        if (found != mesh.materialNames.end())
+            return static_cast<uint16_t>(found - mesh.materialNames.begin());
+        if (mesh.materialNames.size() >= NoMaterial)
+            throw std::runtime_error("Too many materials in object " + mesh.nameMesh);
+        mesh.materialNames.push_back(name);
+        return static_cast<uint16_t>(mesh.materialNames.size() - 1);
+    }
+
+    // Enregistrement qui change l'état du parseur (objet courant, matériau courant),
+    // positionné par le nombre de faces lues avant lui dans le bloc.
+    struct ObjEvent
+    {
+        enum Kind { Mtllib, Usemtl, Object };
+        Kind kind;
+        string name; // copié : le fichier est fermé avant l'assemblage des blocs
+        size_t faceIndex;
+    };
+
+    // Sommet de face tel qu'écrit dans l'OBJ : index[0] = position, index[1] = uv, index[2] = normale (à partir de 1).
+    struct ObjCorner
+    {
+        int index[3];
+
+        bool operator==(const ObjCorner& o) const { return index[0] == o.index[0] && index[1] == o.index[1] && index[2] == o.index[2]; }
+    };
+
+    // Face lue dans le bloc, avant déduplication des sommets.
+    struct ObjFace
+    {
+        ObjCorner corner[3];
+    };
+
+    // Indice relatif (négatif) d'une face, résolu localement au bloc ; il reste à lui ajouter
+    // le nombre d'éléments des blocs précédents. component : 0 = position, 1 = uv, 2 = normale.
+    struct RelativeIndex
+    {
+        size_t face;
+        unsigned char corner;
+        unsigned char component;
+    };
+
+    // Résultat du parsing d'un bloc de lignes du fichier.
+    struct ObjChunk
+    {
+        vector<vec3> vertices;
+        vector<vec2> uvs;
+        vector<vec3> normals;
+        vector<ObjFace> faces;
+        vector<ObjEvent> events;
+        vector<RelativeIndex> relative;
+    };
+
+    // En dessous de cette taille par bloc, le parsing multi-thread ne vaut pas le coût des threads.
+    constexpr size_t ObjMinChunkBytes = 1 << 20;
+
+    // Taille des blocs imposée par R3D_OBJ_CHUNK_BYTES (vérification du recollage des blocs) ; 0 sinon.
+    size_t ForcedObjChunkBytes()
+    {
+        const char* env = std::getenv("R3D_OBJ_CHUNK_BYTES");
+        if (env == nullptr)
+            return 0;
+        return static_cast<size_t>(std::strtoull(env, nullptr, 10));
+    }
+
+    inline const char* ParseIndex(const char* p, const char* end, int& out, size_t localCount, ObjChunk& chunk,
+                                  unsigned char corner, unsigned char component)
+    {
+        p = ParseNumber(p, end, out);
+        if (out < 0)
         {
-            istringstream iss(line);
-            iss >> prefix;
-            if (prefix == "mtllib")
-            {
-                iss >> _nameMtl;
-                _tmpMeshes[iTmp].nameMtl = _nameMtl;
+            out += static_cast<int>(localCount) + 1;
+            chunk.relative.push_back({ chunk.faces.size(), corner, component });
+        }
+        return p;
+    }
 
-            }
-            else if (prefix == "usemtl")
-            {
-                iss >> _useMtl;
+    // Sommet de face au format v/vt/vn.
+    inline const char* ParseFaceVertex(const char* p, const char* end, ObjCorner& out, unsigned char corner, ObjChunk& chunk)
+    {
+        p = ParseIndex(SkipBlanks(p, end), end, out.index[0], chunk.vertices.size(), chunk, corner, 0);
+        if (p == end || *p != '/')
+            throw std::runtime_error("Only faces of the form v/vt/vn are accepted!");
+        p = ParseIndex(p + 1, end, out.index[1], chunk.uvs.size(), chunk, corner, 1);
+        if (p == end || *p != '/')
+            throw std::runtime_error("Only faces of the form v/vt/vn are accepted!");
+        return ParseIndex(p + 1, end, out.index[2], chunk.normals.size(), chunk, corner, 2);
+    }
 
-            }
-            else if (prefix == "o")
-            {
-                _useMtl = "";
-                iss >> _nameMesh;
-                if(nbObjects > 0)
-                {
-                    iTmp++;
-                    _tmpMeshes.push_back(TmpMesh());
-                }
-                
-                _tmpMeshes[iTmp].nameMesh = _nameMesh;
-                
-                nbObjects++;
-            }
-            else if (prefix == "v")
+    // Parse les lignes complètes de [p, fileEnd) dans chunk, sans dépendre des blocs voisins.
+    void ParseObjChunk(const char* p, const char* const fileEnd, ObjChunk& chunk)
+    {
+        while (p < fileEnd)
+        {
+            const char* lineEnd = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(fileEnd - p)));
+            if (lineEnd == nullptr)
+                lineEnd = fileEnd;
+            const char* cursor = p;
+            p = lineEnd + 1;
+
+            string_view prefix = NextToken(cursor, lineEnd);
+            if (prefix.empty() || prefix[0] == '#')
+                continue;
+
+            if (prefix == "v")
             {
                 vec3 v{};
-                iss >> v.x;
-                iss >> v.y;
-                iss >> v.z;
-                _vertices.push_back(v);
-                verticesCount++;
+                cursor = ParseNumber(cursor, lineEnd, v.x);
+                cursor = ParseNumber(cursor, lineEnd, v.y);
+                ParseNumber(cursor, lineEnd, v.z);
+                chunk.vertices.push_back(v);
             }
             else if (prefix == "vt")
             {
                 vec2 v{};
-                iss >> v.x;
-                iss >> v.y;
-                uv.push_back(v);
-
+                cursor = ParseNumber(cursor, lineEnd, v.x);
+                ParseNumber(cursor, lineEnd, v.y);
+                chunk.uvs.push_back(v);
             }
             else if (prefix == "vn")
             {
                 vec3 v{};
-                iss >> v.x;
-                iss >> v.y;
-                iss >> v.z;
-                normal.push_back(v);
+                cursor = ParseNumber(cursor, lineEnd, v.x);
+                cursor = ParseNumber(cursor, lineEnd, v.y);
+                ParseNumber(cursor, lineEnd, v.z);
+                chunk.normals.push_back(v);
             }
             else if (prefix == "f")
             {
-                int numberOfCoordinates = 0;
-                vector<int> v;
-                Face face{};
-                string faceA;
-                string faceB;
-                string faceC;
-                string noMore;
-                string extracted;
-                iss >> faceA >> faceB >> faceC >> noMore;
-
-                if (noMore.empty() == false) {
+                ObjFace face{};
+                cursor = ParseFaceVertex(cursor, lineEnd, face.corner[0], 0, chunk);
+                cursor = ParseFaceVertex(cursor, lineEnd, face.corner[1], 1, chunk);
+                cursor = ParseFaceVertex(cursor, lineEnd, face.corner[2], 2, chunk);
+
+                if (SkipBlanks(cursor, lineEnd) != lineEnd) {
                     throw std::runtime_error("Only files containing triangular faces are accepted!");
                 }
-        
-                istringstream ss(faceA);
-                while (getline(ss, extracted, '/')) {
-                    v.push_back(stoi(extracted));
-                    numberOfCoordinates++;
-                }
+                chunk.faces.push_back(face);
+            }
+            else if (prefix == "mtllib")
+            {
+                chunk.events.push_back({ ObjEvent::Mtllib, string(NextToken(cursor, lineEnd)), chunk.faces.size() });
+            }
+            else if (prefix == "usemtl")
+            {
+                chunk.events.push_back({ ObjEvent::Usemtl, string(NextToken(cursor, lineEnd)), chunk.faces.size() });
+            }
+            else if (prefix == "o")
+            {
+                chunk.events.push_back({ ObjEvent::Object, string(NextToken(cursor, lineEnd)), chunk.faces.size() });
+            }
+        }
+    }
+
+    // Découpe [begin, end) en blocs qui commencent tous en début de ligne.
+    vector<const char*> SplitLines(const char* begin, const char* end, size_t count)
+    {
+        vector<const char*> bounds{ begin };
+        const size_t size = static_cast<size_t>(end - begin);
+        for (size_t i = 1; i < count; i++)
+        {
+            const char* cut = max(begin + size * i / count, bounds.back());
+            const char* newline = static_cast<const char*>(memchr(cut, '\n', static_cast<size_t>(end - cut)));
+            if (newline == nullptr)
+                break;
+            if (newline + 1 > bounds.back())
+                bounds.push_back(newline + 1);
+        }
+        bounds.push_back(end);
+        return bounds;
+    }
+
+    // Parse [begin, end) par blocs de lignes, en parallèle quand la plage est assez grande.
+    vector<ObjChunk> ParseObjRange(const char* begin, const char* end)
+    {
+        const size_t maxChunks = max<size_t>(1, std::thread::hardware_concurrency());
+        const size_t forcedBytes = ForcedObjChunkBytes();
+        const size_t nbChunks = forcedBytes > 0
+            ? max<size_t>(1, static_cast<size_t>(end - begin) / forcedBytes)
+            : std::clamp<size_t>(static_cast<size_t>(end - begin) / ObjMinChunkBytes, 1, maxChunks);
+        const vector<const char*> bounds = SplitLines(begin, end, nbChunks);
+        vector<ObjChunk> chunks(bounds.size() - 1);
+
+        if (chunks.size() == 1)
+        {
+            ParseObjChunk(bounds[0], bounds[1], chunks[0]);
+        }
+        else
+        {
+            // Au plus un thread par coeur ; chacun parse les blocs c, c + nbWorkers, ...
+            const size_t nbWorkers = min(chunks.size(), maxChunks);
+            vector<exception_ptr> errors(chunks.size());
+            vector<std::thread> workers;
+            for (size_t w = 0; w < nbWorkers; w++)
+            {
+                workers.emplace_back([&, w] {
+                    for (size_t c = w; c < chunks.size(); c += nbWorkers)
+                    {
+                        try {
+                            ParseObjChunk(bounds[c], bounds[c + 1], chunks[c]);
+                        }
+                        catch (...) {
+                            errors[c] = current_exception();
+                        }
+                    }
+                });
+            }
+            for (std::thread& worker : workers)
+                worker.join();
+            for (const exception_ptr& error : errors)
+                if (error)
+                    rethrow_exception(error);
+        }
+        return chunks;
+    }
+
+    // Ajoute un tableau d'un bloc à la fin du tableau global ; le premier bloc est déplacé sans copie.
+    template<typename T>
+    void AppendChunk(vector<T>& out, vector<T>& chunk)
+    {
+        if (out.empty() && out.capacity() == 0)
+            out = std::move(chunk);
+        else
+            out.insert(out.end(), chunk.begin(), chunk.end());
+    }
 
-                face.A.IndiceVertices = v[0];
-                face.A.IndiceTexCoords = v[1];
-                face.A.IndiceNormals = v[2];
+    inline uint32_t HashCorner(const ObjCorner& c)
+    {
+        uint64_t h = static_cast<uint32_t>(c.index[0]) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint32_t>(c.index[1]) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<uint32_t>(c.index[2]) * 0x165667B19E3779F9ull;
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    /*
+     * Fusionne les triplets (v, vt, vn) identiques en un seul sommet : chaque coin de face
+     * reçoit un indice unique commun à la position, à l'uv et à la normale.
+     * Les sommets sont numérotés dans l'ordre de première apparition, donc objet par objet,
+     * pour que chaque objet garde une plage de sommets compacte.
+     * Table de hachage à adressage ouvert (sondage linéaire) dimensionnée à deux fois le nombre de coins.
+     */
+    class VertexDeduplicator
+    {
+    public:
+        VertexDeduplicator(size_t corners, size_t nbVertices, size_t nbUvs, size_t nbNormals)
+            : _count{ static_cast<int>(nbVertices), static_cast<int>(nbUvs), static_cast<int>(nbNormals) }
+        {
+            if (corners >= UINT32_MAX / 2)
+                throw std::runtime_error("Too many face vertices in OBJ file");
+            size_t tableSize = 16;
+            while (tableSize < 2 * corners)
+                tableSize <<= 1;
+            _mask = tableSize - 1;
+            _slots.assign(tableSize, 0);
+            _keys.reserve(min(corners, nbVertices + nbUvs + nbNormals));
+        }
+
+        // Indice (à partir de 1) du sommet unifié, créé à la première apparition du triplet.
+        int unify(const ObjCorner& corner)
+        {
+            for (int k = 0; k < 3; k++)
+                if (corner.index[k] < 1 || corner.index[k] > _count[k])
+                    throw std::runtime_error("Face index out of range in OBJ file: " + to_string(corner.index[0]) + "/" +
+                                             to_string(corner.index[1]) + "/" + to_string(corner.index[2]));
+
+            size_t slot = HashCorner(corner) & _mask;
+            while (_slots[slot] != 0 && !(_keys[_slots[slot] - 1] == corner))
+                slot = (slot + 1) & _mask;
+            if (_slots[slot] == 0)
+            {
+                _keys.push_back(corner);
+                _slots[slot] = static_cast<uint32_t>(_keys.size());
+            }
+            return static_cast<int>(_slots[slot]);
+        }
+
+        /*
+         * Construit un tableau par attribut, indexé par sommet unifié. Chaque tableau de l'OBJ
+         * est libéré dès que son attribut est construit : au plus un attribut existe en double.
+         */
+        void build(vector<vec3>& objVertices, vector<vec2>& uvs, vector<vec3>& normals, Vec3SoA& positions)
+        {
+            _slots = vector<uint32_t>();
+
+            positions.resize(_keys.size());
+            for (size_t i = 0; i < _keys.size(); i++)
+                positions.set(i, objVertices[_keys[i].index[0] - 1]);
+            objVertices = vector<vec3>();
+
+            vector<vec2> unifiedUvs(_keys.size());
+            for (size_t i = 0; i < _keys.size(); i++)
+                unifiedUvs[i] = uvs[_keys[i].index[1] - 1];
+            uvs = std::move(unifiedUvs);
+
+            vector<vec3> unifiedNormals(_keys.size());
+            for (size_t i = 0; i < _keys.size(); i++)
+                unifiedNormals[i] = normals[_keys[i].index[2] - 1];
+            normals = std::move(unifiedNormals);
 
-                istringstream ss1(faceB);
-                v.clear();
-                while (getline(ss1, extracted, '/')) {
-                    v.push_back(stoi(extracted));
+            _keys = vector<ObjCorner>();
+        }
+
+        // Triplet (v, vt, vn) de chaque sommet unifié, dans l'ordre de création.
+        const vector<ObjCorner>& keys() const { return _keys; }
+
+    private:
+        int _count[3];
+        size_t _mask = 0;
+        vector<uint32_t> _slots; // indice du sommet + 1, 0 = libre
+        vector<ObjCorner> _keys;
+    };
+
+    /*
+     * Lit tous les matériaux d'un fichier MTL (référencé par son nom dans l'OBJ) dans une table
+     * indexée par nom. Une erreur de lecture est signalée sur cerr ; les matériaux déjà lus sont conservés.
+     */
+    void LoadMtlFile(const string& nameMtl, unordered_map<string, MaterialProperty>& materials)
+    {
+        try {
+            MappedFile file("./" + nameMtl);
+            if (!file.is_open())
+                throw std::runtime_error("cannot open " + nameMtl);
+
+            MaterialProperty* current = nullptr;
+            const char* p = file.begin();
+            const char* const fileEnd = file.end();
+            while (p < fileEnd)
+            {
+                const char* lineEnd = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(fileEnd - p)));
+                if (lineEnd == nullptr)
+                    lineEnd = fileEnd;
+                const char* cursor = p;
+                p = lineEnd + 1;
+
+                string_view prefix = NextToken(cursor, lineEnd);
+                if (prefix == "newmtl")
+                {
+                    // Un matériau défini deux fois est complété par sa seconde définition.
+                    string name(NextToken(cursor, lineEnd));
+                    current = &materials[name];
+                    current->useMtl = name;
+                }
+                else if (current == nullptr)
+                {
+                    continue;
+                }
+                else if (prefix == "Ns")
+                {
+                    ParseNumber(cursor, lineEnd, current->ns);
+                }
+                else if (prefix == "Ka")
+                {
+                    ParseVec3(cursor, lineEnd, current->ka);
+                }
+                else if (prefix == "Kd")
+                {
+                    ParseVec3(cursor, lineEnd, current->kd);
+                }
+                else if (prefix == "Ks")
+                {
+                    ParseVec3(cursor, lineEnd, current->ks);
                 }
+                else if (prefix == "Ke")
+                {
+                    ParseVec3(cursor, lineEnd, current->ke);
+                }
+                /*else if (prefix == "Ni"){}
+                else if (prefix == "d"){}
+                else if (prefix == "illum"){}*/
+                else if (prefix == "map_Kd")
+                {
+                    current->pathTexture = string(NextToken(cursor, lineEnd));
+                }
+                else if (prefix == "map_Bump")
+                {
+                    current->pathTextureBump = string(NextToken(cursor, lineEnd));
+                }
+                else if (prefix == "disp")
+                {
+                    current->pathTextureDisp = string(NextToken(cursor, lineEnd));
+                }
+            }
+        }
+        catch (exception& e)
+        {
+            cerr << "Loading file MTL falure: " << e.what() << endl;
+        }
+    }
+
+    // Taille des fenêtres de l'OBJ parsées à la suite en mode flux.
+    constexpr size_t StreamWindowBytes = size_t(64) << 20;
+    // Nombre de faces visé par cellule de la grille des blocs.
+    constexpr size_t StreamCellFaces = 65536;
+    // Une cellule plus dense est écrite en plusieurs blocs de cette taille.
+    constexpr size_t StreamChunkMaxFaces = 4 * StreamCellFaces;
+    // Mémoire des tampons de répartition des faces entre les cellules.
+    constexpr size_t StreamScatterBytes = size_t(64) << 20;
+
+    // Face déversée sur disque avec son matériau (indice dans la table globale des noms).
+    struct StreamFace
+    {
+        ObjFace face;
+        uint16_t material;
+    };
+
+    // Fichiers intermédiaires du mode flux, supprimés à la fin de la construction, qu'elle réussisse ou non.
+    struct SpillFiles
+    {
+        enum Kind { Vertices, Uvs, Normals, Faces, Cells, Count };
+        string path[Count];
+
+        explicit SpillFiles(const string& prefix)
+        {
+            const char* suffix[Count] = { ".v.tmp", ".vt.tmp", ".vn.tmp", ".f.tmp", ".cells.tmp" };
+            for (int k = 0; k < Count; k++)
+                path[k] = prefix + suffix[k];
+        }
+
+        ~SpillFiles()
+        {
+            error_code ec;
+            for (const string& p : path)
+                filesystem::remove(p, ec);
+        }
+    };
+
+    template<typename T>
+    void Spill(ofstream& out, const vector<T>& v)
+    {
+        out.write(reinterpret_cast<const char*>(v.data()), static_cast<streamsize>(v.size() * sizeof(T)));
+    }
+}
+
+/**
+ * @brief Constructeur de la classe LoadObj
+ * @param path Chemin du fichier OBJ à charger
+ *
+ * Le fichier est projeté en mémoire puis découpé en blocs de lignes parsés en parallèle.
+ * Les blocs sont ensuite recollés dans l'ordre : sommets concaténés, indices relatifs décalés,
+ * et changements d'objet / de matériau rejoués aux faces où ils apparaissent.
+ */
+LoadObj::LoadObj(string path)
+{
+    _path = path;
+    _tmpMeshes.push_back(TmpMesh());
+    verticesCount = 0;
+    facesCount = 0;
+    int nbObjects = 0, iTmp = 0;
+    uint16_t material = NoMaterial;
+
+    try {
+        MappedFile file(path);
+        if (!file.is_open())
+            throw std::runtime_error("cannot open " + path);
+
+        vector<ObjChunk> chunks = ParseObjRange(file.begin(), file.end());
+        file.close(); // les pages du fichier ne s'ajoutent pas aux tableaux construits ensuite
 
-                face.B.IndiceVertices = v[0];
-                face.B.IndiceTexCoords = v[1];
-                face.B.IndiceNormals = v[2];
+        size_t totalVertices = 0, totalUvs = 0, totalNormals = 0, totalFaces = 0;
+        for (const ObjChunk& chunk : chunks)
+        {
+            totalVertices += chunk.vertices.size();
+            totalUvs += chunk.uvs.size();
+            totalNormals += chunk.normals.size();
+            totalFaces += chunk.faces.size();
+        }
+        vector<vec3> objVertices;
+        if (chunks.size() > 1)
+        {
+            objVertices.reserve(totalVertices);
+            uv.reserve(totalUvs);
+            normal.reserve(totalNormals);
+        }
+        VertexDeduplicator dedup(3 * totalFaces, totalVertices, totalUvs, totalNormals);
 
-                istringstream ss2(faceC);
-                v.clear();
-                while (getline(ss2, extracted, '/')) {
-                    v.push_back(stoi(extracted));
+        for (ObjChunk& chunk : chunks)
+        {
+            // Indices relatifs : décalage par le nombre d'éléments des blocs précédents.
+            const int base[3] = { static_cast<int>(objVertices.size()), static_cast<int>(uv.size()), static_cast<int>(normal.size()) };
+            for (const RelativeIndex& r : chunk.relative)
+                chunk.faces[r.face].corner[r.corner].index[r.component] += base[r.component];
+
+            AppendChunk(objVertices, chunk.vertices);
+            AppendChunk(uv, chunk.uvs);
+            AppendChunk(normal, chunk.normals);
+
+            // Faces dédupliquées et rangées dans leur objet par plages entre deux événements.
+            size_t firstFace = 0;
+            auto flushFaces = [&](size_t lastFace) {
+                if (lastFace == firstFace)
+                    return;
+                vector<Face>& faces = _tmpMeshes[iTmp].faces;
+                for (size_t j = firstFace; j < lastFace; j++)
+                {
+                    const ObjFace& f = chunk.faces[j];
+                    faces.push_back({ { dedup.unify(f.corner[0]) }, { dedup.unify(f.corner[1]) }, { dedup.unify(f.corner[2]) } });
                 }
+                _tmpMeshes[iTmp].faceMaterial.insert(_tmpMeshes[iTmp].faceMaterial.end(), lastFace - firstFace, material);
+                facesCount += static_cast<int>(lastFace - firstFace);
+                firstFace = lastFace;
+            };
 
-                face.C.IndiceVertices = v[0];
-                face.C.IndiceTexCoords = v[1];
-                face.C.IndiceNormals = v[2];
+            for (const ObjEvent& event : chunk.events)
+            {
+                flushFaces(event.faceIndex);
+                if (event.kind == ObjEvent::Mtllib)
+                {
+                    _nameMtl = event.name;
+                    _tmpMeshes[iTmp].nameMtl = _nameMtl;
+                }
+                else if (event.kind == ObjEvent::Usemtl)
+                {
+                    _useMtl = event.name;
+                    material = InternMaterial(_tmpMeshes[iTmp], _useMtl);
+                }
+                else
+                {
+                    _useMtl = "";
+                    material = NoMaterial;
+                    _nameMesh = event.name;
+                    if(nbObjects > 0)
+                    {
+                        iTmp++;
+                        _tmpMeshes.push_back(TmpMesh());
+                    }
 
-                _faces.push_back(face);
-                _tmpMeshes[iTmp].faces.push_back(face);
-                if(_useMtl.empty() == false)
-                    _tmpMeshes[iTmp].useMtl.push_back(_useMtl);
+                    _tmpMeshes[iTmp].nameMesh = _nameMesh;
 
-                facesCount++;
+                    nbObjects++;
+                }
             }
+            flushFaces(chunk.faces.size());
+            chunk = ObjChunk(); // recopié : libéré avant le bloc suivant
         }
 
-        setUvs(uv);
-        setNormals(normal);
-
+        dedup.build(objVertices, uv, normal, _vertices);
+        verticesCount = static_cast<int>(_vertices.size());
     }
     catch (exception& e)
     {
@@ -163,29 +630,46 @@ LoadObj::LoadObj(string path)
 /**
  * @brief Remplit un objet Mesh à partir des données chargées
  * @param meshes Référence vers l'objet Mesh à remplir
+ *
+ * Les données chargées sont déplacées dans le Mesh : à n'appeler qu'une fois.
  */
 void LoadObj::get_Mesh(Mesh& meshes)
 {
     try {
-        for(auto m :_tmpMeshes){
+        // Sans 'mtllib', les faces gardent l'éclairage par défaut (pas de matériau).
+        const bool hasMtl = _nameMtl.empty() == false;
+        if (hasMtl)
+            loadMtl();
+
+        for(TmpMesh& m :_tmpMeshes){
             MeshData md;
             md.nameMesh = m.nameMesh;
-            md.faces = m.faces;
-  
-            for(auto prop : m.useMtl){
-                loadMtl(prop, md);
+            md.faces = std::move(m.faces);
+
+            if (hasMtl && m.materialNames.empty() == false)
+            {
+                for (const string& name : m.materialNames)
+                {
+                    auto found = _materials.find(name);
+                    MaterialProperty material = found != _materials.end() ? found->second : MaterialProperty{};
+                    material.useMtl = name;
+                    md.material.push_back(std::move(material));
+                }
+                md.faceMaterial = std::move(m.faceMaterial);
             }
            
-            meshes.get_meshData().push_back(md);
+            meshes.get_meshData().push_back(std::move(md));
         }
 
-        meshes.set_faces(_faces);
+        meshes.set_normals(std::move(normal));
 
-        meshes.set_normals(normal);
+        meshes.set_uvs(std::move(uv));
 
-        meshes.set_uvs(uv);
+        meshes.set_vertices(std::move(_vertices));
 
-        meshes.set_vertices(_vertices);
+        meshes.build_meshlets();
+
+        meshes.build_bvh();
     }
     catch (const out_of_range& oor)
     {
@@ -196,131 +680,295 @@ void LoadObj::get_Mesh(Mesh& meshes)
 }
 
 /**
- * @brief Charge les propriétés du matériau à partir d'un fichier MTL
- * @param useMtl Nom du matériau à utiliser
- * @param meshData Structure MeshData à remplir avec les propriétés du matériau
+ * @brief Charge tous les matériaux du fichier MTL dans la table _materials
+ *
+ * Le fichier est projeté en mémoire et lu une seule fois, avec le même découpage
+ * en mots que le fichier OBJ.
+ */
+void LoadObj::loadMtl() {
+    if (_nameMtl == _loadedMtl)
+        return;
+    _materials.clear();
+    LoadMtlFile(_nameMtl, _materials);
+    _loadedMtl = _nameMtl;
+}
+
+/**
+ * @brief Construit le flux par blocs (.r3ds) d'un OBJ en mémoire bornée
+ * @param path Chemin du fichier OBJ
+ *
+ * Trois passes, dont aucune ne garde le maillage entier en mémoire :
+ * - parsing par fenêtres et déversement des sommets et des faces (indices rendus absolus) ;
+ * - comptage puis répartition des faces par cellule de la grille, dans un fichier trié par cellule ;
+ * - construction et écriture d'un Mesh autonome par cellule.
  */
-void LoadObj::loadMtl(const string useMtl, MeshData& meshData) {
+bool LoadObj::buildStream(const string& path)
+{
     try {
-        MaterialProperty matprop;
-        matprop.useMtl = useMtl;
-        string pathTexture, pathTextureBump, pathTextureDisp;
-        if (_nameMtl.empty() == false) {
-            ifstream file(strdup(("./" + _nameMtl).c_str()));
-            string line;
-            string prefix, tmp;
-            string mtl = "";
-
-            while (getline(file, line))
+        SpillFiles spill(path + ".r3ds");
+        string nameMtl;
+        vector<string> materialNames;
+        unordered_map<string, uint16_t> materialIndex;
+        size_t counts[3] = { 0, 0, 0 };
+        size_t faceCount = 0;
+        vec3 bbMin(FLT_MAX), bbMax(-FLT_MAX);
+
+        // ===== Parsing et déversement =====
+        {
+            MappedFile file(path);
+            if (!file.is_open())
+                throw std::runtime_error("cannot open " + path);
+
+            ofstream out[4];
+            for (int k = SpillFiles::Vertices; k <= SpillFiles::Faces; k++)
             {
-                istringstream iss(line);
-                iss >> prefix;
-                if(prefix == "newmtl")
-                {
-                   iss >> mtl;
-                }
-                if (prefix == "Ns")
-                {
-                    iss >> _ns;
-                    if(mtl == useMtl){
-                        matprop.ns = _ns;
-                    }
-                    
-                }
-                if (prefix == "Ka")
-                {
-                    iss >> _ka.x;
-                    iss >> _ka.y;
-                    iss >> _ka.z;
+                out[k].open(spill.path[k], ios::binary | ios::trunc);
+                if (!out[k])
+                    throw std::runtime_error("cannot write " + spill.path[k]);
+            }
 
-                    if(mtl == useMtl){
-                        matprop.ka = _ka;
-                    }
-                }
-                if (prefix == "Kd")
+            uint16_t material = NoMaterial;
+            const char* window = file.begin();
+            while (window < file.end())
+            {
+                const char* windowEnd = file.end();
+                if (static_cast<size_t>(file.end() - window) > StreamWindowBytes)
                 {
-                    iss >> _kd.x;
-                    iss >> _kd.y;
-                    iss >> _kd.z;
-
-                    if(mtl == useMtl){
-                        matprop.kd = _kd;
-                    }
+                    const char* cut = window + StreamWindowBytes;
+                    const char* newline = static_cast<const char*>(memchr(cut, '\n', static_cast<size_t>(file.end() - cut)));
+                    windowEnd = newline != nullptr ? newline + 1 : file.end();
                 }
-                if (prefix == "Ks")
+                vector<ObjChunk> chunks = ParseObjRange(window, windowEnd);
+                file.discard(static_cast<size_t>(window - file.begin()), static_cast<size_t>(windowEnd - window));
+                window = windowEnd;
+
+                for (ObjChunk& chunk : chunks)
                 {
-                    iss >> tmp;
-                    _ks.x = stof(tmp);
-                    iss >> tmp;
-                    _ks.y = stof(tmp);
-                    iss >> tmp;
-                    _ks.z = stof(tmp);
-
-                    if(mtl == useMtl){
-                        matprop.ks = _ks;
+                    const int base[3] = { static_cast<int>(counts[0]), static_cast<int>(counts[1]), static_cast<int>(counts[2]) };
+                    for (const RelativeIndex& r : chunk.relative)
+                        chunk.faces[r.face].corner[r.corner].index[r.component] += base[r.component];
+
+                    for (const vec3& v : chunk.vertices)
+                    {
+                        bbMin = min(bbMin, v);
+                        bbMax = max(bbMax, v);
                     }
-                }
-                if (prefix == "Ke")
-                {
-                    iss >> tmp;
-                    _ke.x = stof(tmp);
-                    iss >> tmp;
-                    _ke.y = stof(tmp);
-                    iss >> tmp;
-                    _ke.z = stof(tmp);
-
-                    if(mtl == useMtl){
-                        matprop.ke = _ke;
+                    Spill(out[SpillFiles::Vertices], chunk.vertices);
+                    Spill(out[SpillFiles::Uvs], chunk.uvs);
+                    Spill(out[SpillFiles::Normals], chunk.normals);
+                    counts[0] += chunk.vertices.size();
+                    counts[1] += chunk.uvs.size();
+                    counts[2] += chunk.normals.size();
+                    if (max({ counts[0], counts[1], counts[2] }) > static_cast<size_t>(INT_MAX))
+                        throw std::runtime_error("Too many vertices in OBJ file");
+
+                    // Matériau courant rejoué aux faces où il change ; un nouvel objet repart sans matériau.
+                    vector<StreamFace> faces;
+                    faces.reserve(chunk.faces.size());
+                    size_t firstFace = 0;
+                    auto flushFaces = [&](size_t lastFace) {
+                        for (; firstFace < lastFace; firstFace++)
+                            faces.push_back({ chunk.faces[firstFace], material });
+                    };
+                    for (const ObjEvent& event : chunk.events)
+                    {
+                        flushFaces(event.faceIndex);
+                        if (event.kind == ObjEvent::Mtllib)
+                        {
+                            nameMtl = event.name;
+                        }
+                        else if (event.kind == ObjEvent::Usemtl)
+                        {
+                            auto found = materialIndex.find(event.name);
+                            if (found == materialIndex.end())
+                            {
+                                if (materialNames.size() >= NoMaterial)
+                                    throw std::runtime_error("Too many materials in OBJ file");
+                                found = materialIndex.emplace(event.name, static_cast<uint16_t>(materialNames.size())).first;
+                                materialNames.push_back(event.name);
+                            }
+                            material = found->second;
+                        }
+                        else
+                        {
+                            material = NoMaterial;
+                        }
                     }
+                    flushFaces(chunk.faces.size());
+                    Spill(out[SpillFiles::Faces], faces);
+                    faceCount += faces.size();
+                    chunk = ObjChunk();
                 }
-                /*if (prefix == "Ni"){}
-                if (prefix == "d"){}
-                if (prefix == "illum"){}*/
-                if (prefix == "map_Kd")
+            }
+
+            for (int k = SpillFiles::Vertices; k <= SpillFiles::Faces; k++)
+            {
+                out[k].close();
+                if (!out[k])
+                    throw std::runtime_error("cannot write " + spill.path[k]);
+            }
+        }
+
+        // ===== Répartition des faces dans la grille =====
+        // Les axes sont subdivisés tour à tour, le plus long par cellule d'abord ; un axe plat reste entier.
+        const vec3 extent = faceCount > 0 ? bbMax - bbMin : vec3(0.0f);
+        int dims[3] = { 1, 1, 1 };
+        const size_t targetCells = max<size_t>(1, faceCount / StreamCellFaces);
+        while (static_cast<size_t>(dims[0]) * dims[1] * dims[2] < targetCells)
+        {
+            int axis = -1;
+            for (int a = 0; a < 3; a++)
+                if (extent[a] > 0.0f && (axis < 0 || extent[a] / dims[a] > extent[axis] / dims[axis]))
+                    axis = a;
+            if (axis < 0)
+                break;
+            dims[axis]++;
+        }
+        const size_t cellCount = static_cast<size_t>(dims[0]) * dims[1] * dims[2];
+
+        MappedFile positionsFile(spill.path[SpillFiles::Vertices]), facesFile(spill.path[SpillFiles::Faces]);
+        const vec3* positions = reinterpret_cast<const vec3*>(positionsFile.data());
+        const StreamFace* faces = reinterpret_cast<const StreamFace*>(facesFile.data());
+
+        auto cellOf = [&](const StreamFace& f) {
+            vec3 center(0.0f);
+            for (const ObjCorner& corner : f.face.corner)
+            {
+                if (corner.index[0] < 1 || static_cast<size_t>(corner.index[0]) > counts[0])
+                    throw std::runtime_error("Face index out of range in OBJ file: " + to_string(corner.index[0]));
+                center += positions[corner.index[0] - 1];
+            }
+            center /= 3.0f;
+            size_t cell = 0;
+            for (int a = 2; a >= 0; a--)
+            {
+                const int k = extent[a] > 0.0f ? std::clamp(static_cast<int>((center[a] - bbMin[a]) / extent[a] * dims[a]), 0, dims[a] - 1) : 0;
+                cell = cell * dims[a] + k;
+            }
+            return cell;
+        };
+
+        vector<size_t> cellStart(cellCount + 1, 0);
+        for (size_t j = 0; j < faceCount; j++)
+            cellStart[cellOf(faces[j]) + 1]++;
+        for (size_t c = 0; c < cellCount; c++)
+            cellStart[c + 1] += cellStart[c];
+
+        {
+            ofstream cells(spill.path[SpillFiles::Cells], ios::binary | ios::trunc);
+            const size_t bufferFaces = max<size_t>(64, StreamScatterBytes / sizeof(StreamFace) / cellCount);
+            vector<vector<StreamFace>> buffers(cellCount);
+            vector<size_t> written(cellStart.begin(), cellStart.end() - 1);
+            auto flushCell = [&](size_t c) {
+                cells.seekp(static_cast<streamoff>(written[c] * sizeof(StreamFace)));
+                Spill(cells, buffers[c]);
+                written[c] += buffers[c].size();
+                buffers[c].clear();
+            };
+            for (size_t j = 0; j < faceCount; j++)
+            {
+                const size_t c = cellOf(faces[j]);
+                buffers[c].push_back(faces[j]);
+                if (buffers[c].size() == bufferFaces)
+                    flushCell(c);
+            }
+            for (size_t c = 0; c < cellCount; c++)
+                flushCell(c);
+            cells.close();
+            if (!cells)
+                throw std::runtime_error("cannot write " + spill.path[SpillFiles::Cells]);
+        }
+        facesFile.close();
+
+        // ===== Un Mesh par cellule =====
+        unordered_map<string, MaterialProperty> materials;
+        if (!nameMtl.empty())
+            LoadMtlFile(nameMtl, materials);
+
+        MappedFile cellsFile(spill.path[SpillFiles::Cells]), uvsFile(spill.path[SpillFiles::Uvs]), normalsFile(spill.path[SpillFiles::Normals]);
+        const StreamFace* sorted = reinterpret_cast<const StreamFace*>(cellsFile.data());
+        const vec2* uvs = reinterpret_cast<const vec2*>(uvsFile.data());
+        const vec3* normals = reinterpret_cast<const vec3*>(normalsFile.data());
+
+        MeshStreamWriter writer(path);
+        size_t chunkCount = 0;
+        for (size_t c = 0; c < cellCount; c++)
+        {
+            for (size_t first = cellStart[c]; first < cellStart[c + 1]; first += StreamChunkMaxFaces)
+            {
+                const size_t last = min(first + StreamChunkMaxFaces, cellStart[c + 1]);
+
+                MeshData md;
+                md.nameMesh = "chunk " + to_string(chunkCount);
+                VertexDeduplicator dedup(3 * (last - first), counts[0], counts[1], counts[2]);
+                vector<uint16_t> localMaterial(materialNames.size(), NoMaterial);
+                md.faces.reserve(last - first);
+                md.faceMaterial.reserve(last - first);
+                for (size_t j = first; j < last; j++)
                 {
-                    iss >> pathTexture;
-                    if(mtl == useMtl){
-                        matprop.pathTexture = pathTexture;
+                    const StreamFace& f = sorted[j];
+                    md.faces.push_back({ { dedup.unify(f.face.corner[0]) }, { dedup.unify(f.face.corner[1]) }, { dedup.unify(f.face.corner[2]) } });
+
+                    uint16_t m = NoMaterial;
+                    if (f.material != NoMaterial)
+                    {
+                        if (localMaterial[f.material] == NoMaterial)
+                        {
+                            auto found = materials.find(materialNames[f.material]);
+                            MaterialProperty material = found != materials.end() ? found->second : MaterialProperty{};
+                            material.useMtl = materialNames[f.material];
+                            localMaterial[f.material] = static_cast<uint16_t>(md.material.size());
+                            md.material.push_back(std::move(material));
+                        }
+                        m = localMaterial[f.material];
                     }
+                    md.faceMaterial.push_back(m);
                 }
-                if (prefix == "map_Bump")
+                // Comme get_Mesh : sans 'mtllib' ou sans 'usemtl', les faces gardent l'éclairage par défaut.
+                if (nameMtl.empty() || md.material.empty())
                 {
-                    iss >> pathTextureBump;
-                    if(mtl == useMtl){
-                        matprop.pathTextureBump = pathTextureBump;
-                    }
+                    md.material.clear();
+                    md.faceMaterial = vector<uint16_t>();
                 }
-                if (prefix == "disp")
+
+                const vector<ObjCorner>& keys = dedup.keys();
+                Vec3SoA chunkPositions;
+                chunkPositions.resize(keys.size());
+                vector<vec2> chunkUvs(keys.size());
+                vector<vec3> chunkNormals(keys.size());
+                for (size_t k = 0; k < keys.size(); k++)
                 {
-                    iss >> pathTextureDisp;
-                    if(mtl == useMtl){
-                        matprop.pathTextureDisp = pathTextureDisp;
-                    }
+                    chunkPositions.set(k, positions[keys[k].index[0] - 1]);
+                    chunkUvs[k] = uvs[keys[k].index[1] - 1];
+                    chunkNormals[k] = normals[keys[k].index[2] - 1];
                 }
+
+                Mesh chunk;
+                chunk.get_meshData().push_back(std::move(md));
+                chunk.set_vertices(std::move(chunkPositions));
+                chunk.set_uvs(std::move(chunkUvs));
+                chunk.set_normals(std::move(chunkNormals));
+                chunk.build_meshlets();
+                writer.addChunk(chunk);
+                cellsFile.discard(first * sizeof(StreamFace), (last - first) * sizeof(StreamFace));
+                chunkCount++;
             }
-            meshData.material.push_back(matprop);
         }
+        writer.finish(path, nameMtl);
+        cout << "Geometry stream : " << chunkCount << " chunks, " << faceCount << " faces (grid " << dims[0] << "x" << dims[1] << "x" << dims[2] << ")" << endl;
+        return true;
     }
     catch (exception& e)
     {
-        cerr << "Loading file MTL falure: " << e.what() << endl;
+        cerr << "Streaming file OBJ failure; " << e.what() << endl;
+        return false;
     }
-
-
-}
-
-/**
- * @brief Définit les coordonnées de texture UV
- * @param v Vecteur de coordonnées UV
- */
-void LoadObj::setUvs(vector<vec2> v) {
-    _uvs = v;
 }
 
 /**
- * @brief Définit les normales
- * @param v Vecteur de normales
+ * @brief Récupère le nom du fichier MTL référencé par l'OBJ
+ * @return Nom du fichier MTL
  */
-void LoadObj::setNormals(vector<vec3> v) {
-    _normals = v;
+const string& LoadObj::get_nameMtl() const {
+    return _nameMtl;
 }
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <unordered_map>
 #include "Mesh.hpp"
 
 
@@ -45,7 +46,8 @@ namespace Render3D
     struct TmpMesh{
         string nameMesh;
         string nameMtl;
-        vector<string> useMtl;
+        vector<string> materialNames;  // matériaux distincts utilisés par l'objet (usemtl)
+        vector<uint16_t> faceMaterial; // pour chaque face, indice dans materialNames ou NoMaterial
         vector<Face> faces;
         float ns;
         vec3 ka;
@@ -64,21 +66,13 @@ namespace Render3D
         string _path;
         string _nameMesh;
         string _nameMtl;
+        string _loadedMtl; // MTL dont les matériaux sont dans _materials
         string _useMtl;
-        vector<vec3> _vertices;
-        vector<vec2> _uvs;
-        vector<vec3> _normals;
-        vector<Face> _faces;
+        Vec3SoA _vertices;
         vector<TmpMesh> _tmpMeshes;
         int verticesCount;
         int facesCount;
-        float _ns;
-        vec3 _ka;
-        vec3 _kd;
-        vec3 _ks;
-        vec3 _ke;
-
-        vector<VerticesLoading> vertices;
+        unordered_map<string, MaterialProperty> _materials;
 
         vector<vec2> uv;
 
@@ -94,7 +88,7 @@ namespace Render3D
          * @param meshes Référence vers l'objet Mesh à remplir
          *
          * Convertit les structures temporaires (TmpMesh) en structures MeshData
-         * et charge les propriétés des matériaux depuis le fichier MTL.
+         * et résout les matériaux de chaque objet dans la table lue une seule fois depuis le MTL.
          * Remplit également les vertices, normales, UV et faces du mesh.
          *
          * @throw out_of_range si l'accès aux données dépasse les limites des vecteurs
@@ -102,11 +96,10 @@ namespace Render3D
         void get_Mesh(Mesh& meshes);
 
         /**
-         * @brief Charge les propriétés d'un matériau depuis un fichier MTL
-         * @param useMtl Nom du matériau à charger (doit correspondre à 'newmtl' dans le MTL)
-         * @param meshData Référence vers la structure MeshData à remplir
+         * @brief Charge tous les matériaux du fichier MTL dans la table _materials
          *
-         * Parse le fichier MTL et extrait les propriétés suivantes :
+         * Le fichier est parcouru une seule fois ; chaque 'newmtl' crée une entrée
+         * indexée par son nom. Les propriétés extraites sont :
          * - Ns : exposant spéculaire (shininess)
          * - Ka : couleur ambiante (RGB)
          * - Kd : couleur diffuse (RGB)
@@ -116,21 +109,29 @@ namespace Render3D
          * - map_Bump : chemin de la texture de bump mapping
          * - disp : chemin de la texture de displacement
          *
-         * @throw exception si le fichier MTL ne peut pas être ouvert
+         * Une erreur de lecture est signalée sur cerr ; les matériaux déjà lus sont conservés.
+         * Sans effet si ce MTL est déjà chargé.
          */
-        void loadMtl(const string useMtl, MeshData& meshData);
+        void loadMtl();
 
         /**
-         * @brief Définit les coordonnées de texture UV
-         * @param v Vecteur contenant les coordonnées UV (vec2) à stocker
+         * @brief Construit le flux par blocs (.r3ds) d'un OBJ en mémoire bornée
+         * @param path Chemin du fichier OBJ
+         * @return false si l'OBJ ne peut pas être lu ou le flux écrit (erreur signalée sur cerr)
+         *
+         * L'OBJ est parsé par fenêtres de 64 Mo ; positions, uv, normales et faces sont déversées
+         * dans des fichiers temporaires à côté du flux. Les faces sont ensuite réparties par le centre
+         * de leur triangle dans une grille régulière sur la boîte de la scène (environ 65536 faces
+         * par cellule), et chaque cellule devient un bloc autonome (MeshStreamWriter) : sommets
+         * dédupliqués, meshlets et matériaux du MTL. Les objets de l'OBJ sont fusionnés dans les blocs.
          */
-        void setUvs(vector<vec2> v);
+        static bool buildStream(const string& path);
 
         /**
-         * @brief Définit les vecteurs normaux
-         * @param v Vecteur contenant les normales (vec3) à stocker
+         * @brief Récupère le nom du fichier MTL référencé par l'OBJ (mtllib)
+         * @return Nom du fichier MTL, vide si l'OBJ n'en déclare pas
          */
-        void setNormals(vector<vec3> v);
+        const string& get_nameMtl() const;
     };
 };
 #endif /* LoadObj_hpp */
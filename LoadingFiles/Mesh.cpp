@@ -7,6 +7,7 @@
 //
 
 #include "Mesh.hpp"
+#include <algorithm>
 using namespace Render3D;
 
 string Mesh::get_name()
@@ -19,13 +20,14 @@ void Mesh::set_name(string name)
     _name = name;
 };
 
-vector<vec3> Mesh::get_vertices() {
-    return _vertices;
+void Mesh::set_vertices(Vec3SoA vertices)
+{
+    _verticesSoA = std::move(vertices);
 }
 
-void Mesh::set_vertices(vector<vec3> v)
+const Vec3SoA& Mesh::get_vertices_soa() const
 {
-    _vertices = v;
+    return _verticesSoA;
 }
 
 vec3 Mesh::get_position(int i)
@@ -38,6 +40,7 @@ void Mesh::set_position(int i,float x, float y, float z)
    _meshData[i].position.x = x;
    _meshData[i].position.y = y;
    _meshData[i].position.z = z;
+   _bvhDirty = true;
 };
 
 vec3 Mesh::get_rotation(int i)
@@ -50,6 +53,7 @@ void Mesh::set_rotation(int i, float x, float y, float z)
     _meshData[i].rotation.x = x;
     _meshData[i].rotation.y = y;
     _meshData[i].rotation.z = z;
+    _bvhDirty = true;
 };
 
 int Mesh::get_count()
@@ -74,16 +78,6 @@ Mesh::~Mesh()
 
 };
 
-void Mesh::set_faces(vector<Face> faces)
-{
-    _faces = faces;
-}
-
-vector<Face> Mesh::get_faces()
-{
-    return _faces;
-};
-
 void Mesh::set_pathtexture(string pathTexture)
 {
     _pathTexture = pathTexture;
@@ -119,17 +113,29 @@ void Mesh::set_indice_vertices(vector<int>& indiceVertices) {
 }
 
 void Mesh::set_uvs(vector<vec2> v) {
-    _uv = v;
+    _uv = std::move(v);
 }
 void Mesh::set_normals(vector<vec3> v) {
-    _normal = v;
+    _normal = std::move(v);
 }
 
-vector<vec2> Mesh::get_uvs() {
+const vector<vec2>& Mesh::get_uvs() const {
     return _uv;
 }
 
-vector<vec3> Mesh::get_normals() {
+size_t Mesh::get_memoryUsage() const
+{
+    size_t bytes = (_verticesSoA.x.capacity() + _verticesSoA.y.capacity() + _verticesSoA.z.capacity()) * sizeof(float);
+    bytes += _uv.capacity() * sizeof(vec2) + _normal.capacity() * sizeof(vec3);
+    for (const MeshData& md : _meshData)
+    {
+        bytes += md.faces.capacity() * sizeof(Face) + md.indices.capacity() * sizeof(uint32_t);
+        bytes += md.meshlets.capacity() * sizeof(Meshlet) + md.faceMaterial.capacity() * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+const vector<vec3>& Mesh::get_normals() const {
     return _normal;
 }
 
@@ -138,19 +144,303 @@ vector<MeshData>& Mesh::get_meshData() {
 }
 
 ConstantLight Mesh::get_ConstantLight(int i, int j)
+{
+    const MeshData& md = get_meshData()[i];
+    return get_MaterialConstantLight(i, static_cast<size_t>(j) < md.faceMaterial.size() ? md.faceMaterial[j] : NoMaterial);
+}
+
+ConstantLight Mesh::get_MaterialConstantLight(int i, uint16_t m)
 {
     ConstantLight constantLight;
+    const MeshData& md = get_meshData()[i];
     
-    if(get_meshData()[i].material.size() > 0){
-        constantLight.Ns = get_meshData()[i].material[j].ns;
-        constantLight.Ka = get_meshData()[i].material[j].ka;
-        constantLight.Kd = get_meshData()[i].material[j].kd;
-        constantLight.Ks = get_meshData()[i].material[j].ks;
-        constantLight.Ke = get_meshData()[i].material[j].ke;
-        constantLight.pathTexture = get_meshData()[i].material[j].pathTexture;
-        constantLight.pathTextureBump = get_meshData()[i].material[j].pathTextureBump;
-        constantLight.pathTextureDisp = get_meshData()[i].material[j].pathTextureDisp;
+    if(m != NoMaterial && m < md.material.size()){
+        const MaterialProperty& material = md.material[m];
+        constantLight.Ns = material.ns;
+        constantLight.Ka = material.ka;
+        constantLight.Kd = material.kd;
+        constantLight.Ks = material.ks;
+        constantLight.Ke = material.ke;
+        constantLight.pathTexture = material.pathTexture;
+        constantLight.pathTextureBump = material.pathTextureBump;
+        constantLight.pathTextureDisp = material.pathTextureDisp;
     }
     
     return constantLight;
-}
\ No newline at end of file
+}
+
+// Normale unitaire d'une face (nulle si la face est dégénérée).
+static vec3 ComputeFaceNormal(const Vec3SoA& vertices, const Face& f)
+{
+    vec3 a = vertices.get(f.A.IndiceVertices - 1);
+    vec3 b = vertices.get(f.B.IndiceVertices - 1);
+    vec3 c = vertices.get(f.C.IndiceVertices - 1);
+    vec3 n = cross(b - a, c - a);
+    float len = length(n);
+    return len > 0.0f ? n / len : vec3(0.0f);
+}
+
+// Calcule la sphère englobante et le cône de normales d'un meshlet.
+static void FinalizeMeshlet(Meshlet& meshlet, const Vec3SoA& vertices, const vector<Face>& faces)
+{
+    vec3 bbMin = vertices.get(faces[meshlet.firstFace].A.IndiceVertices - 1);
+    vec3 bbMax = bbMin;
+    vec3 normalSum(0.0f);
+
+    for (int j = meshlet.firstFace; j < meshlet.firstFace + meshlet.faceCount; j++)
+    {
+        const Face& f = faces[j];
+        for (int k : {f.A.IndiceVertices, f.B.IndiceVertices, f.C.IndiceVertices})
+        {
+            bbMin = min(bbMin, vertices.get(k - 1));
+            bbMax = max(bbMax, vertices.get(k - 1));
+        }
+        normalSum += ComputeFaceNormal(vertices, f);
+    }
+
+    meshlet.bbMin = bbMin;
+    meshlet.bbMax = bbMax;
+    meshlet.center = (bbMin + bbMax) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (int j = meshlet.firstFace; j < meshlet.firstFace + meshlet.faceCount; j++)
+    {
+        const Face& f = faces[j];
+        for (int k : {f.A.IndiceVertices, f.B.IndiceVertices, f.C.IndiceVertices})
+        {
+            meshlet.radius = std::max(meshlet.radius, length(vertices.get(k - 1) - meshlet.center));
+        }
+    }
+
+    // Cône de normales : axe moyen et plus grand écart angulaire.
+    // Un cône plus ouvert que ~84° ne permet aucun rejet (cutoff = 1).
+    meshlet.coneCutoff = 1.0f;
+    float axisLength = length(normalSum);
+    if (axisLength <= 0.0f)
+    {
+        meshlet.coneAxis = vec3(0.0f);
+        return;
+    }
+    meshlet.coneAxis = normalSum / axisLength;
+
+    float minDot = 1.0f;
+    for (int j = meshlet.firstFace; j < meshlet.firstFace + meshlet.faceCount; j++)
+    {
+        vec3 n = ComputeFaceNormal(vertices, faces[j]);
+        if (n != vec3(0.0f))
+            minDot = std::min(minDot, dot(meshlet.coneAxis, n));
+    }
+
+    if (minDot > 0.1f)
+        meshlet.coneCutoff = sqrt(1.0f - minDot * minDot);
+}
+
+void Mesh::build_meshlets()
+{
+    for (MeshData& md : _meshData)
+    {
+        md.meshlets.clear();
+        int facesCount = static_cast<int>(md.faces.size());
+        if (facesCount == 0)
+            continue;
+
+        vector<vec3> faceNormals(facesCount);
+        int lastVertex = 0;
+        md.firstVertex = static_cast<int>(_verticesSoA.size());
+        for (int j = 0; j < facesCount; j++)
+        {
+            const Face& f = md.faces[j];
+            md.firstVertex = std::min({md.firstVertex, f.A.IndiceVertices - 1, f.B.IndiceVertices - 1, f.C.IndiceVertices - 1});
+            lastVertex = std::max({lastVertex, f.A.IndiceVertices, f.B.IndiceVertices, f.C.IndiceVertices});
+            faceNormals[j] = ComputeFaceNormal(_verticesSoA, f);
+        }
+        md.vertexCount = lastVertex - md.firstVertex;
+
+        // Faces adjacentes à chaque sommet de l'objet, en tableaux compacts (CSR) :
+        // les faces du sommet v sont vertexFaces[vertexStart[v]] .. vertexFaces[vertexStart[v + 1] - 1].
+        vector<int> vertexStart(md.vertexCount + 1, 0);
+        for (const Face& f : md.faces)
+            for (int k : {f.A.IndiceVertices, f.B.IndiceVertices, f.C.IndiceVertices})
+                vertexStart[k - md.firstVertex]++;
+        for (int v = 0; v < md.vertexCount; v++)
+            vertexStart[v + 1] += vertexStart[v];
+        vector<int> vertexFaces(vertexStart[md.vertexCount]);
+        vector<int> vertexFill(vertexStart.begin(), vertexStart.end() - 1);
+        for (int j = 0; j < facesCount; j++)
+        {
+            const Face& f = md.faces[j];
+            for (int k : {f.A.IndiceVertices, f.B.IndiceVertices, f.C.IndiceVertices})
+                vertexFaces[vertexFill[k - 1 - md.firstVertex]++] = j;
+        }
+
+        auto faceMaterial = [&md](int j) { return md.faceMaterial.empty() ? NoMaterial : md.faceMaterial[j]; };
+
+        // Croissance de régions : on part de la première face libre et on
+        // ajoute les faces voisines (sommet partagé) de même matériau dont
+        // la normale reste dans un cône de ~37° autour de celle du germe.
+        vector<bool> assigned(facesCount, false);
+        vector<int> order;
+        order.reserve(facesCount);
+
+        for (int seed = 0; seed < facesCount; seed++)
+        {
+            if (assigned[seed])
+                continue;
+
+            Meshlet meshlet;
+            meshlet.firstFace = static_cast<int>(order.size());
+            vec3 seedNormal = faceNormals[seed];
+
+            assigned[seed] = true;
+            order.push_back(seed);
+            meshlet.faceCount = 1;
+
+            for (size_t next = meshlet.firstFace; next < order.size() && meshlet.faceCount < Meshlet::MaxFaces; next++)
+            {
+                const Face& f = md.faces[order[next]];
+                for (int k : {f.A.IndiceVertices, f.B.IndiceVertices, f.C.IndiceVertices})
+                {
+                    const int v = k - 1 - md.firstVertex;
+                    for (int n = vertexStart[v]; n < vertexStart[v + 1]; n++)
+                    {
+                        const int neighbour = vertexFaces[n];
+                        if (assigned[neighbour] || meshlet.faceCount >= Meshlet::MaxFaces)
+                            continue;
+                        if (dot(seedNormal, faceNormals[neighbour]) < 0.8f || faceMaterial(neighbour) != faceMaterial(seed))
+                            continue;
+
+                        assigned[neighbour] = true;
+                        order.push_back(neighbour);
+                        meshlet.faceCount++;
+                    }
+                }
+            }
+
+            md.meshlets.push_back(meshlet);
+        }
+
+        // Meshlets rangés par matériau (ordre de création conservé à matériau égal) :
+        // chaque matériau couvre ensuite une plage contiguë de meshlets et de faces.
+        vector<int> byMaterial(md.meshlets.size());
+        for (size_t m = 0; m < byMaterial.size(); m++)
+            byMaterial[m] = static_cast<int>(m);
+        std::stable_sort(byMaterial.begin(), byMaterial.end(), [&](int a, int b) {
+            return faceMaterial(order[md.meshlets[a].firstFace]) < faceMaterial(order[md.meshlets[b].firstFace]);
+        });
+
+        vector<Meshlet> meshlets;
+        vector<int> sortedOrder;
+        meshlets.reserve(md.meshlets.size());
+        sortedOrder.reserve(facesCount);
+        for (int m : byMaterial)
+        {
+            Meshlet meshlet = md.meshlets[m];
+            sortedOrder.insert(sortedOrder.end(), order.begin() + meshlet.firstFace, order.begin() + meshlet.firstFace + meshlet.faceCount);
+            meshlet.firstFace = static_cast<int>(sortedOrder.size()) - meshlet.faceCount;
+            meshlets.push_back(meshlet);
+        }
+        md.meshlets = std::move(meshlets);
+        order = std::move(sortedOrder);
+
+        // Réordonne les faces (et leurs indices de matériau) dans
+        // l'ordre des meshlets pour que chaque groupe soit contigu.
+        vector<Face> faces(facesCount);
+        for (int j = 0; j < facesCount; j++)
+            faces[j] = md.faces[order[j]];
+        md.faces = std::move(faces);
+
+        if (md.faceMaterial.size() == static_cast<size_t>(facesCount))
+        {
+            vector<uint16_t> faceMaterial(facesCount);
+            for (int j = 0; j < facesCount; j++)
+                faceMaterial[j] = md.faceMaterial[order[j]];
+            md.faceMaterial = std::move(faceMaterial);
+        }
+
+        for (Meshlet& meshlet : md.meshlets)
+            FinalizeMeshlet(meshlet, _verticesSoA, md.faces);
+    }
+
+    build_indices();
+    build_batches();
+}
+
+void Mesh::build_indices()
+{
+    for (MeshData& md : _meshData)
+    {
+        md.indices.resize(3 * md.faces.size());
+        for (size_t j = 0; j < md.faces.size(); j++)
+        {
+            const Face& f = md.faces[j];
+            md.indices[3 * j] = static_cast<uint32_t>(f.A.IndiceVertices - 1 - md.firstVertex);
+            md.indices[3 * j + 1] = static_cast<uint32_t>(f.B.IndiceVertices - 1 - md.firstVertex);
+            md.indices[3 * j + 2] = static_cast<uint32_t>(f.C.IndiceVertices - 1 - md.firstVertex);
+        }
+    }
+}
+
+void Mesh::build_batches()
+{
+    for (MeshData& md : _meshData)
+    {
+        md.batches.clear();
+        for (int m = 0; m < static_cast<int>(md.meshlets.size()); m++)
+        {
+            const Meshlet& meshlet = md.meshlets[m];
+            const uint16_t material = md.faceMaterial.empty() ? NoMaterial : md.faceMaterial[meshlet.firstFace];
+            if (md.batches.empty() || md.batches.back().material != material)
+                md.batches.push_back({material, m, 0});
+            md.batches.back().meshletCount++;
+        }
+    }
+}
+
+mat4x4 Mesh::get_world_matrix(int i)
+{
+    mat4x4 T, Rx, Ry, Rz, Rm, S;
+    Rotation_X_Pitch(Rx, get_rotation(i).x);
+    Rotation_Y_Yaw(Ry, get_rotation(i).y);
+    Rotation_Z_Roll(Rz, get_rotation(i).z);
+    Rotation_XYZ_PitchYawRoll(Rx, Ry, Rz, Rm);
+    BuildTranslationMatrix(get_position(i), T);
+    Scale(1.0f, S);
+
+    return T * Rm * S;
+}
+
+void Mesh::build_bvh()
+{
+    vector<BVHLeaf> leaves;
+    vector<mat4x4> worldMatrices;
+
+    for (int i = 0; i < static_cast<int>(_meshData.size()); i++)
+    {
+        worldMatrices.push_back(get_world_matrix(i));
+        for (int m = 0; m < static_cast<int>(_meshData[i].meshlets.size()); m++)
+        {
+            BVHLeaf leaf;
+            leaf.object = i;
+            leaf.meshlet = m;
+            leaf.localMin = _meshData[i].meshlets[m].bbMin;
+            leaf.localMax = _meshData[i].meshlets[m].bbMax;
+            leaves.push_back(leaf);
+        }
+    }
+
+    _bvh.build(leaves, worldMatrices);
+    _bvhDirty = false;
+}
+
+SceneBVH& Mesh::get_bvh()
+{
+    if (_bvhDirty)
+    {
+        vector<mat4x4> worldMatrices;
+        for (int i = 0; i < static_cast<int>(_meshData.size()); i++)
+            worldMatrices.push_back(get_world_matrix(i));
+
+        _bvh.refit(worldMatrices);
+        _bvhDirty = false;
+    }
+    return _bvh;
+}
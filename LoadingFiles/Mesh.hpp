@@ -10,10 +10,12 @@
 #define Mesh_hpp
 
 #include <stdio.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "../Tools/MatrixTools.h"
 #include "../OutPut/ConstantLight.hpp"
+#include "../OutPut/SceneBVH.hpp"
 #include <iostream>
 
 using namespace std;
@@ -42,22 +44,16 @@ namespace Render3D
 
     /**
      * @struct Info
-     * @brief Informations d'un sommet de face avec indices et propriétés géométriques
+     * @brief Sommet d'une face
      *
-     * Cette structure stocke les indices pointant vers les données globales du mesh
-     * ainsi que les propriétés calculées pour ce sommet spécifique.
+     * Les sommets sont dédupliqués au chargement : un même indice (à partir de 1) désigne
+     * la position, la coordonnée de texture et la normale. Rien d'autre n'est stocké dans la face :
+     * la base tangente est calculée par triangle au rendu (TextureNormalMap::getTBN) et les
+     * données d'occlusion dans des tableaux par sommet (AmbientOcclusion).
      */
     struct Info
     {
         int IndiceVertices;
-        int IndiceTexCoords;
-        int IndiceNormals;
-        vec3 Tangent;
-        vec3 Bitangent;
-        float area = 0.0f;
-        float occlusion = 0.0f;
-        float prevOcclusion = 0.0f;
-
     };
 
     /**
@@ -74,6 +70,8 @@ namespace Render3D
         Info C;
     };
 
+    static_assert(sizeof(Face) == 12, "Face reste un triplet d'indices");
+
     /**
      * @struct MaterialProperty
      * @brief Propriétés d'un matériau pour l'éclairage
@@ -89,11 +87,63 @@ namespace Render3D
         string pathTexture;
         string pathTextureBump;
         string pathTextureDisp;
-        float ns;
-        vec3 ka;
-        vec3 kd;
-        vec3 ks;
-        vec3 ke;
+        float ns = 0.0f;
+        vec3 ka = {0.0f, 0.0f, 0.0f};
+        vec3 kd = {0.0f, 0.0f, 0.0f};
+        vec3 ks = {0.0f, 0.0f, 0.0f};
+        vec3 ke = {0.0f, 0.0f, 0.0f};
+    };
+
+    /// Indice de matériau d'une face qui précède tout 'usemtl' de son objet.
+    constexpr uint16_t NoMaterial = 0xFFFF;
+
+    /**
+     * @struct Meshlet
+     * @brief Groupe contigu de faces (cluster) avec ses volumes englobants
+     *
+     * Un meshlet regroupe jusqu'à 128 faces voisines et contiguës d'un MeshData.
+     * Il porte une boîte et une sphère englobantes et un cône de normales (en espace objet)
+     * qui permettent de rejeter tout le groupe en un seul test, que ce soit
+     * hors du frustum ou entièrement orienté vers l'arrière.
+     */
+    struct Meshlet
+    {
+        static constexpr int MaxFaces = 128;
+
+        int firstFace = 0;
+        int faceCount = 0;
+        vec3 bbMin = {0.0f, 0.0f, 0.0f};
+        vec3 bbMax = {0.0f, 0.0f, 0.0f};
+        vec3 center = {0.0f, 0.0f, 0.0f};
+        float radius = 0.0f;
+        vec3 coneAxis = {0.0f, 0.0f, 0.0f};
+        float coneCutoff = 1.0f;
+
+        /**
+         * @brief Teste si toutes les faces du meshlet tournent le dos à la caméra
+         * @param cameraPosition Position de la caméra dans l'espace objet
+         * @return true si le meshlet peut être rejeté entièrement
+         *
+         * Test conservatif du cône de normales : un coneCutoff de 1 (cône trop
+         * ouvert ou dégénéré) ne rejette jamais rien.
+         */
+        bool isBackFacing(const vec3& cameraPosition) const {
+            vec3 toCenter = center - cameraPosition;
+            return dot(toCenter, coneAxis) >= coneCutoff * length(toCenter) + radius;
+        }
+    };
+
+    /**
+     * @struct MaterialBatch
+     * @brief Lot de rendu : plage contiguë de meshlets (et donc de faces) partageant un matériau
+     *
+     * Les constantes du matériau et ses textures sont résolues une fois par lot.
+     */
+    struct MaterialBatch
+    {
+        uint16_t material = NoMaterial; // indice dans MeshData::material
+        int firstMeshlet = 0;
+        int meshletCount = 0;
     };
 
     /**
@@ -102,16 +152,22 @@ namespace Render3D
      *
      * Cette structure regroupe toutes les informations d'un objet 3D :
      * - Identification (noms)
-     * - Géométrie (faces)
+     * - Géométrie (faces, meshlets et plage de vertices utilisée)
      * - Matériau (propriétés d'éclairage et textures)
      * - Transformation (position, rotation)
      */
     struct MeshData{
         string nameMesh;
         vector<Face> faces;
-        vector<MaterialProperty> material;
-        vec3 position;
-        vec3 rotation;
+        vector<uint32_t> indices;          // index buffer : 3 sommets par face, relatifs à firstVertex
+        vector<Meshlet> meshlets;
+        vector<MaterialBatch> batches;     // meshlets regroupés par matériau
+        vector<MaterialProperty> material; // matériaux distincts du sous-mesh
+        vector<uint16_t> faceMaterial;     // indice dans material pour chaque face (vide sans matériau)
+        int firstVertex = 0;
+        int vertexCount = 0;
+        vec3 position = {0.0f, 0.0f, 0.0f};
+        vec3 rotation = {0.0f, 0.0f, 0.0f};
     };
 
     /**
@@ -135,15 +191,16 @@ namespace Render3D
             string _name;
             vector<int> _indiceVertices;
             vector<float> __normals;
-            vector<Face> _faces;
             int _count;
             string _pathTexture;
             string _pathTextureBump;
             string _pathTextureDisp;
-            vector<vec3> _vertices;
+            Vec3SoA _verticesSoA;
             vector<vec2> _uv;
             vector<vec3> _normal;
             vector<MeshData> _meshData;
+            SceneBVH _bvh;
+            bool _bvhDirty = false;
         
         public:
 
@@ -152,18 +209,30 @@ namespace Render3D
 
             /**
              * @brief Définit la liste des positions de vertices
-             * @param vertices Vecteur de positions 3D
+             * @param vertices Positions rangées en SoA, déplacées dans le Mesh (seule copie des positions)
              */
-            void set_vertices(vector<vec3> vertices);
+            void set_vertices(Vec3SoA vertices);
 
-            vector<vec3> get_vertices();
+            /**
+             * @brief Récupère les positions des vertices rangées en SoA
+             * @return Référence constante vers les tableaux x, y, z
+             */
+            const Vec3SoA& get_vertices_soa() const;
             vec3 get_position(int i);
+
+            /**
+             * @brief Modifie la position d'un sous-mesh
+             * @note Marque le BVH de la scène pour un refit au prochain get_bvh()
+             */
             void set_position(int i, float x, float y, float z);
             vec3 get_rotation( int i );
+
+            /**
+             * @brief Modifie la rotation d'un sous-mesh
+             * @note Marque le BVH de la scène pour un refit au prochain get_bvh()
+             */
             void set_rotation(int i, float x, float y, float z);
             int get_count();
-            void set_faces(vector<Face> faces);
-            vector<Face> get_faces();
             Mesh();
             Mesh(string name, int verticesCount, int facesCount);
             ~Mesh();
@@ -233,13 +302,19 @@ namespace Render3D
              * @brief Récupère les coordonnées UV
              * @return Vecteur de coordonnées UV
              */
-            vector<vec2> get_uvs();
+            const vector<vec2>& get_uvs() const;
 
             /**
              * @brief Récupère les normales
              * @return Vecteur de normales
              */
-            vector<vec3> get_normals();
+            const vector<vec3>& get_normals() const;
+
+            /**
+             * @brief Mémoire réservée par la géométrie du Mesh
+             * @return Octets alloués pour les sommets, les faces, les index buffers, les meshlets et les matériaux par face
+             */
+            size_t get_memoryUsage() const;
 
             // ===== Getters pour les mesh data =====
         
@@ -255,13 +330,66 @@ namespace Render3D
             /**
              * @brief Extrait les propriétés d'éclairage d'un sous-mesh
              * @param i Indice du sous-mesh dans _meshData
-             * @param j Indice du matériel dans _meshData
+             * @param j Indice de la face dans le sous-mesh (son matériau est lu via faceMaterial)
              * @return Structure ConstantLight contenant Ns, Ka, Kd, Ks, Ke
              * 
              * Cette méthode convertit les propriétés de matériau MTL en structure
              * utilisable par le pipeline de rendu pour calculer l'éclairage.
              */
-            ConstantLight get_ConstantLight(int i, int j);    
+            ConstantLight get_ConstantLight(int i, int j);
+
+            /**
+             * @brief Extrait les propriétés d'éclairage d'un matériau d'un sous-mesh
+             * @param i Indice du sous-mesh dans _meshData
+             * @param m Indice du matériau dans material (NoMaterial : éclairage par défaut)
+             */
+            ConstantLight get_MaterialConstantLight(int i, uint16_t m);
+
+            // ===== Partitionnement en meshlets =====
+
+            /**
+             * @brief Découpe les faces de chaque sous-mesh en meshlets
+             *
+             * Les faces voisines de même matériau et d'orientation proche sont
+             * regroupées (au plus MaxFaces par meshlet). Les meshlets sont rangés
+             * par matériau, puis les faces et leurs matériaux sont réordonnés pour
+             * que chaque meshlet soit une plage contiguë.
+             * Calcule aussi la plage de vertices utilisée par chaque sous-mesh
+             * et les lots de rendu (build_batches).
+             */
+            void build_meshlets();
+
+            /**
+             * @brief Construit l'index buffer de chaque sous-mesh à partir de ses faces
+             * @note Appelé par build_meshlets() (après réordonnancement des faces et calcul de firstVertex)
+             */
+            void build_indices();
+
+            /**
+             * @brief Regroupe les meshlets consécutifs de même matériau en lots de rendu
+             * @note Appelé par build_meshlets() ; à rappeler si les meshlets sont fournis autrement
+             */
+            void build_batches();
+
+            /**
+             * @brief Construit la matrice monde (translation * rotation * échelle) d'un sous-mesh
+             * @param i Indice du sous-mesh dans _meshData
+             */
+            mat4x4 get_world_matrix(int i);
+
+            // ===== Hiérarchie de volumes englobants =====
+
+            /**
+             * @brief Construit le BVH de la scène sur tous les meshlets de tous les sous-meshes
+             * @note À appeler après build_meshlets()
+             */
+            void build_bvh();
+
+            /**
+             * @brief Récupère le BVH de la scène, réajusté si une transformation a changé
+             * @return Référence vers le BVH
+             */
+            SceneBVH& get_bvh();
     };
 };
 #endif /* Mesh_hpp */
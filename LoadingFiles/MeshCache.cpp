@@ -0,0 +1,546 @@
+/**
+ * @file MeshCache.cpp
+ * @brief Écriture et relecture du cache binaire .r3dm.
+ */
+
+#include "MeshCache.hpp"
+#include "../Tools/MappedFile.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+using namespace std;
+using namespace Render3D;
+
+namespace
+{
+    constexpr char CacheMagic[4] = { 'R', '3', 'D', 'M' };
+    constexpr uint32_t CacheVersion = 4;
+    constexpr size_t CacheAlignment = 64;
+
+    enum Section
+    {
+        PositionX,       // float[vertices]
+        PositionY,       // float[vertices]
+        PositionZ,       // float[vertices]
+        TexCoords,       // float[2 * uvs]
+        Normals,         // float[3 * normals]
+        Objects,         // ObjectRecord[objets]
+        ObjectFaces,     // int32[3 * faces] : sommets A, B, C des faces de chaque objet, dans l'ordre des meshlets
+        ObjectMaterials, // uint32[] : indice dans Materials pour chaque entrée de MeshData::material
+        FaceMaterials,   // uint16[] : MeshData::faceMaterial de chaque objet
+        Meshlets,        // MeshletRecord[]
+        Materials,       // MaterialRecord[matériaux distincts]
+        Strings,         // char[] : noms et chemins, référencés par (offset, longueur)
+        SectionCount
+    };
+
+    struct StringRef
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        SourceStamp obj;
+        SourceStamp mtl;
+        StringRef mtlName;
+        uint64_t offset[SectionCount];
+        uint64_t size[SectionCount]; // en octets
+    };
+
+    struct ObjectRecord
+    {
+        StringRef name;
+        uint32_t firstFace;
+        uint32_t faceCount;
+        uint32_t firstMeshlet;
+        uint32_t meshletCount;
+        uint32_t firstMaterial;
+        uint32_t materialCount;
+        uint32_t firstFaceMaterial;
+        uint32_t faceMaterialCount;
+        int32_t firstVertex;
+        int32_t vertexCount;
+    };
+
+    struct MeshletRecord
+    {
+        int32_t firstFace;
+        int32_t faceCount;
+        float bbMin[3];
+        float bbMax[3];
+        float center[3];
+        float radius;
+        float coneAxis[3];
+        float coneCutoff;
+    };
+
+    struct MaterialRecord
+    {
+        StringRef useMtl;
+        StringRef pathTexture;
+        StringRef pathTextureBump;
+        StringRef pathTextureDisp;
+        float ns;
+        float ka[3];
+        float kd[3];
+        float ks[3];
+        float ke[3];
+    };
+
+    constexpr size_t FaceInts = 3;
+
+    static_assert(sizeof(vec2) == 2 * sizeof(float) && sizeof(vec3) == 3 * sizeof(float), "UV et normales sont copiées telles quelles");
+
+    bool CacheEnabled()
+    {
+        const char* env = std::getenv("R3D_MESH_CACHE");
+        return env == nullptr || strcmp(env, "0") != 0;
+    }
+
+    string CachePath(const string& objPath)
+    {
+        return objPath + ".r3dm";
+    }
+
+    void WriteFace(vector<int32_t>& out, const Face& f)
+    {
+        out.push_back(f.A.IndiceVertices);
+        out.push_back(f.B.IndiceVertices);
+        out.push_back(f.C.IndiceVertices);
+    }
+
+    Face ReadFace(const int32_t* in)
+    {
+        return Face{ { in[0] }, { in[1] }, { in[2] } };
+    }
+
+    // Écrit les sections directement dans le flux : l'image n'est jamais assemblée en mémoire.
+    // Les décalages sont relatifs au début de l'image (position du flux à la construction).
+    class CacheWriter
+    {
+    public:
+        explicit CacheWriter(ostream& out) : _out(out), _start(out.tellp())
+        {
+            const char zeros[sizeof(CacheHeader)] = {};
+            _out.write(zeros, sizeof(zeros));
+            _size = sizeof(CacheHeader);
+        }
+
+        StringRef addString(const string& s)
+        {
+            StringRef ref{ static_cast<uint32_t>(_strings.size()), static_cast<uint32_t>(s.size()) };
+            _strings.insert(_strings.end(), s.begin(), s.end());
+            return ref;
+        }
+
+        void addSection(Section section, const void* data, size_t bytes)
+        {
+            const char padding[CacheAlignment] = {};
+            const size_t aligned = (_size + CacheAlignment - 1) / CacheAlignment * CacheAlignment;
+            _out.write(padding, static_cast<streamsize>(aligned - _size));
+            _header.offset[section] = aligned;
+            _header.size[section] = bytes;
+            _out.write(static_cast<const char*>(data), static_cast<streamsize>(bytes));
+            _size = aligned + bytes;
+        }
+
+        template<typename T>
+        void addSection(Section section, const vector<T>& v)
+        {
+            addSection(section, v.data(), v.size() * sizeof(T));
+        }
+
+        CacheHeader& header() { return _header; }
+
+        // Ajoute la table des chaînes puis écrit l'en-tête au début de l'image ; le flux reste positionné à sa fin.
+        void finish()
+        {
+            addSection(Strings, _strings.data(), _strings.size());
+            memcpy(_header.magic, CacheMagic, sizeof(CacheMagic));
+            _header.version = CacheVersion;
+            _out.seekp(_start);
+            _out.write(reinterpret_cast<const char*>(&_header), sizeof(CacheHeader));
+            _out.seekp(_start + static_cast<streamoff>(_size));
+        }
+
+    private:
+        ostream& _out;
+        streampos _start;
+        size_t _size = 0;
+        CacheHeader _header{};
+        vector<char> _strings;
+    };
+
+    // Vue typée sur une section de l'image projetée (les sections sont alignées sur 64 octets).
+    template<typename T>
+    struct SectionView
+    {
+        const T* data = nullptr;
+        size_t count = 0;
+    };
+
+    template<typename T>
+    bool GetSection(const char* image, size_t imageSize, const CacheHeader& header, Section section, SectionView<T>& out)
+    {
+        const uint64_t offset = header.offset[section], size = header.size[section];
+        if (offset % alignof(T) != 0 || size % sizeof(T) != 0 || offset > imageSize || size > imageSize - offset)
+            return false;
+        out.data = reinterpret_cast<const T*>(image + offset);
+        out.count = static_cast<size_t>(size / sizeof(T));
+        return true;
+    }
+
+    // Sections de géométrie, d'objets et de matériaux d'un Mesh.
+    void WriteImage(CacheWriter& writer, Mesh& meshes)
+    {
+        const Vec3SoA& positions = meshes.get_vertices_soa();
+        writer.addSection(PositionX, positions.x);
+        writer.addSection(PositionY, positions.y);
+        writer.addSection(PositionZ, positions.z);
+        writer.addSection(TexCoords, meshes.get_uvs());
+        writer.addSection(Normals, meshes.get_normals());
+
+        vector<ObjectRecord> objects;
+        vector<int32_t> objectFaces;
+        vector<uint32_t> objectMaterials;
+        vector<uint16_t> faceMaterials;
+        vector<MeshletRecord> meshlets;
+        vector<MaterialRecord> materials;
+        unordered_map<string, uint32_t> materialIndex; // loadMtl ne dépend que du nom du matériau
+
+        for (const MeshData& md : meshes.get_meshData())
+        {
+            ObjectRecord object{};
+            object.name = writer.addString(md.nameMesh);
+            object.firstFace = static_cast<uint32_t>(objectFaces.size() / FaceInts);
+            object.faceCount = static_cast<uint32_t>(md.faces.size());
+            object.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+            object.meshletCount = static_cast<uint32_t>(md.meshlets.size());
+            object.firstMaterial = static_cast<uint32_t>(objectMaterials.size());
+            object.materialCount = static_cast<uint32_t>(md.material.size());
+            object.firstFaceMaterial = static_cast<uint32_t>(faceMaterials.size());
+            object.faceMaterialCount = static_cast<uint32_t>(md.faceMaterial.size());
+            object.firstVertex = md.firstVertex;
+            object.vertexCount = md.vertexCount;
+            objects.push_back(object);
+
+            for (const Face& f : md.faces)
+                WriteFace(objectFaces, f);
+            faceMaterials.insert(faceMaterials.end(), md.faceMaterial.begin(), md.faceMaterial.end());
+
+            for (const Meshlet& m : md.meshlets)
+            {
+                MeshletRecord r{ m.firstFace, m.faceCount,
+                                 { m.bbMin.x, m.bbMin.y, m.bbMin.z }, { m.bbMax.x, m.bbMax.y, m.bbMax.z },
+                                 { m.center.x, m.center.y, m.center.z }, m.radius,
+                                 { m.coneAxis.x, m.coneAxis.y, m.coneAxis.z }, m.coneCutoff };
+                meshlets.push_back(r);
+            }
+
+            for (const MaterialProperty& p : md.material)
+            {
+                auto found = materialIndex.find(p.useMtl);
+                if (found == materialIndex.end())
+                {
+                    MaterialRecord r{ writer.addString(p.useMtl), writer.addString(p.pathTexture),
+                                      writer.addString(p.pathTextureBump), writer.addString(p.pathTextureDisp),
+                                      p.ns, { p.ka.x, p.ka.y, p.ka.z }, { p.kd.x, p.kd.y, p.kd.z },
+                                      { p.ks.x, p.ks.y, p.ks.z }, { p.ke.x, p.ke.y, p.ke.z } };
+                    found = materialIndex.emplace(p.useMtl, static_cast<uint32_t>(materials.size())).first;
+                    materials.push_back(r);
+                }
+                objectMaterials.push_back(found->second);
+            }
+        }
+
+        writer.addSection(Objects, objects);
+        writer.addSection(ObjectFaces, objectFaces);
+        writer.addSection(ObjectMaterials, objectMaterials);
+        writer.addSection(FaceMaterials, faceMaterials);
+        writer.addSection(Meshlets, meshlets);
+        writer.addSection(Materials, materials);
+    }
+}
+
+uint64_t Render3D::HashBytes(const char* data, size_t size)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 0x9FB21C651E98DF25ull;
+        h ^= h >> 29;
+    }
+    for (; i < size; i++)
+        h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001B3ull;
+    return h;
+}
+
+SourceStamp Render3D::StampFile(const string& path, bool withHash)
+{
+    SourceStamp stamp{};
+    error_code ec;
+    if (path.empty() || !filesystem::is_regular_file(path, ec))
+        return stamp;
+    stamp.exists = 1;
+    stamp.size = filesystem::file_size(path, ec);
+    stamp.mtime = static_cast<int64_t>(filesystem::last_write_time(path, ec).time_since_epoch().count());
+    if (withHash)
+    {
+        MappedFile file(path);
+        stamp.hash = HashBytes(file.data(), file.size());
+        stamp.hashed = 1;
+    }
+    return stamp;
+}
+
+bool Render3D::SameSource(const SourceStamp& cached, const string& path)
+{
+    SourceStamp current = StampFile(path, false);
+    if (current.exists != cached.exists)
+        return false;
+    if (!current.exists)
+        return true;
+    if (current.size != cached.size)
+        return false;
+    if (current.mtime == cached.mtime)
+        return true;
+    if (!cached.hashed)
+        return false;
+    return StampFile(path, true).hash == cached.hash;
+}
+
+string Render3D::MtlPath(const string& mtlName)
+{
+    return "./" + mtlName; // même résolution que LoadObj::loadMtl
+}
+
+
+void Render3D::SaveMeshCache(const string& objPath, const string& mtlName, Mesh& meshes)
+{
+    if (!CacheEnabled())
+        return;
+
+    // Écriture dans un fichier temporaire puis renommage : un cache n'est jamais lu à moitié écrit.
+    const string path = CachePath(objPath), tmpPath = path + ".tmp";
+    ofstream out(tmpPath, ios::binary | ios::trunc);
+    if (!out)
+    {
+        cerr << "Mesh cache not written: cannot write " << tmpPath << endl;
+        return;
+    }
+
+    CacheWriter writer(out);
+    CacheHeader& header = writer.header();
+    header.obj = StampFile(objPath, true);
+    header.mtl = StampFile(mtlName.empty() ? string() : MtlPath(mtlName), true);
+    header.mtlName = writer.addString(mtlName);
+
+    WriteImage(writer, meshes);
+    writer.finish();
+    out.close();
+
+    error_code ec;
+    if (!out)
+    {
+        cerr << "Mesh cache not written: cannot write " << tmpPath << endl;
+        filesystem::remove(tmpPath, ec);
+        return;
+    }
+    filesystem::rename(tmpPath, path, ec);
+    if (ec)
+    {
+        cerr << "Mesh cache not written: " << ec.message() << endl;
+        filesystem::remove(tmpPath, ec);
+    }
+}
+
+bool Render3D::LoadMeshCache(const string& objPath, Mesh& meshes)
+{
+    if (!CacheEnabled())
+        return false;
+
+    MappedFile file(CachePath(objPath));
+    if (!file.is_open() || file.size() < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    memcpy(&header, file.data(), sizeof(CacheHeader));
+    SectionView<char> strings;
+    if (memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 || header.version != CacheVersion ||
+        !GetSection(file.data(), file.size(), header, Strings, strings) ||
+        header.mtlName.offset > strings.count || header.mtlName.length > strings.count - header.mtlName.offset)
+        return false;
+
+    // Sources modifiées depuis l'écriture du cache : il sera réécrit après le parsing de l'OBJ.
+    const string mtlName(strings.data + header.mtlName.offset, header.mtlName.length);
+    if (!SameSource(header.obj, objPath) || !SameSource(header.mtl, mtlName.empty() ? string() : MtlPath(mtlName)))
+        return false;
+
+    return ReadMeshImage(file.data(), file.size(), meshes);
+}
+
+void Render3D::WriteMeshImage(ostream& out, Mesh& meshes)
+{
+    CacheWriter writer(out);
+    WriteImage(writer, meshes);
+    writer.finish();
+}
+
+bool Render3D::ReadMeshImage(const char* data, size_t size, Mesh& meshes)
+{
+    if (size < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    memcpy(&header, data, sizeof(CacheHeader));
+    if (memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 || header.version != CacheVersion)
+        return false;
+
+    SectionView<float> px, py, pz, uvs, normals;
+    SectionView<int32_t> objectFaces;
+    SectionView<ObjectRecord> objects;
+    SectionView<uint32_t> objectMaterials;
+    SectionView<uint16_t> faceMaterials;
+    SectionView<MeshletRecord> meshlets;
+    SectionView<MaterialRecord> materials;
+    SectionView<char> strings;
+    if (!GetSection(data, size, header, PositionX, px) || !GetSection(data, size, header, PositionY, py) || !GetSection(data, size, header, PositionZ, pz) ||
+        !GetSection(data, size, header, TexCoords, uvs) || !GetSection(data, size, header, Normals, normals) ||
+        !GetSection(data, size, header, Objects, objects) ||
+        !GetSection(data, size, header, ObjectFaces, objectFaces) || !GetSection(data, size, header, ObjectMaterials, objectMaterials) ||
+        !GetSection(data, size, header, FaceMaterials, faceMaterials) ||
+        !GetSection(data, size, header, Meshlets, meshlets) || !GetSection(data, size, header, Materials, materials) ||
+        !GetSection(data, size, header, Strings, strings))
+        return false;
+
+    auto validString = [&](const StringRef& s) { return s.offset <= strings.count && s.length <= strings.count - s.offset; };
+    auto getString = [&](const StringRef& s) { return string(strings.data + s.offset, s.length); };
+
+    // Sommets dédupliqués : position, uv et normale partagent le même indice.
+    if (py.count != px.count || pz.count != px.count || uvs.count != 2 * px.count || normals.count != 3 * px.count ||
+        objectFaces.count % FaceInts != 0)
+        return false;
+
+    for (size_t i = 0; i < objects.count; i++)
+    {
+        const ObjectRecord& o = objects.data[i];
+        if (!validString(o.name) || o.firstFace > objectFaces.count / FaceInts || o.faceCount > objectFaces.count / FaceInts - o.firstFace ||
+            o.firstMeshlet > meshlets.count || o.meshletCount > meshlets.count - o.firstMeshlet ||
+            o.firstMaterial > objectMaterials.count || o.materialCount > objectMaterials.count - o.firstMaterial ||
+            o.firstFaceMaterial > faceMaterials.count || o.faceMaterialCount > faceMaterials.count - o.firstFaceMaterial ||
+            (o.faceMaterialCount != 0 && o.faceMaterialCount != o.faceCount) ||
+            o.firstVertex < 0 || o.vertexCount < 0 || static_cast<size_t>(o.firstVertex) > px.count ||
+            static_cast<size_t>(o.vertexCount) > px.count - static_cast<size_t>(o.firstVertex))
+            return false;
+        for (uint32_t j = 0; j < o.faceMaterialCount; j++)
+        {
+            const uint16_t m = faceMaterials.data[o.firstFaceMaterial + j];
+            if (m != NoMaterial && m >= o.materialCount)
+                return false;
+        }
+        // Meshlets dans les faces de l'objet, jamais vides ni plus grands que les tampons du rendu.
+        for (uint32_t j = 0; j < o.meshletCount; j++)
+        {
+            const MeshletRecord& r = meshlets.data[o.firstMeshlet + j];
+            if (r.firstFace < 0 || r.faceCount < 1 || r.faceCount > Meshlet::MaxFaces ||
+                static_cast<uint32_t>(r.firstFace) >= o.faceCount || static_cast<uint32_t>(r.faceCount) > o.faceCount - static_cast<uint32_t>(r.firstFace))
+                return false;
+        }
+        // Indices des faces dans la plage de sommets de l'objet (build_indices les rend relatifs à firstVertex).
+        const int32_t* faces = objectFaces.data + FaceInts * static_cast<size_t>(o.firstFace);
+        for (size_t k = 0; k < FaceInts * o.faceCount; k++)
+            if (faces[k] <= o.firstVertex || faces[k] > o.firstVertex + o.vertexCount)
+                return false;
+    }
+    for (size_t i = 0; i < objectMaterials.count; i++)
+        if (objectMaterials.data[i] >= materials.count)
+            return false;
+    for (size_t i = 0; i < materials.count; i++)
+    {
+        const MaterialRecord& r = materials.data[i];
+        if (!validString(r.useMtl) || !validString(r.pathTexture) || !validString(r.pathTextureBump) || !validString(r.pathTextureDisp))
+            return false;
+    }
+
+    // Le cache est cohérent : remplissage du Mesh par copies de tableaux.
+    Vec3SoA vertices;
+    vertices.x.assign(px.data, px.data + px.count);
+    vertices.y.assign(py.data, py.data + py.count);
+    vertices.z.assign(pz.data, pz.data + pz.count);
+
+    vector<vec2> uv(uvs.count / 2);
+    memcpy(static_cast<void*>(uv.data()), uvs.data, uv.size() * sizeof(vec2));
+    vector<vec3> normal(normals.count / 3);
+    memcpy(static_cast<void*>(normal.data()), normals.data, normal.size() * sizeof(vec3));
+
+    vector<MaterialProperty> materialTable(materials.count);
+    for (size_t i = 0; i < materials.count; i++)
+    {
+        const MaterialRecord& r = materials.data[i];
+        MaterialProperty& p = materialTable[i];
+        p.useMtl = getString(r.useMtl);
+        p.pathTexture = getString(r.pathTexture);
+        p.pathTextureBump = getString(r.pathTextureBump);
+        p.pathTextureDisp = getString(r.pathTextureDisp);
+        p.ns = r.ns;
+        p.ka = vec3(r.ka[0], r.ka[1], r.ka[2]);
+        p.kd = vec3(r.kd[0], r.kd[1], r.kd[2]);
+        p.ks = vec3(r.ks[0], r.ks[1], r.ks[2]);
+        p.ke = vec3(r.ke[0], r.ke[1], r.ke[2]);
+    }
+
+    for (size_t i = 0; i < objects.count; i++)
+    {
+        const ObjectRecord& o = objects.data[i];
+        MeshData md;
+        md.nameMesh = getString(o.name);
+        md.firstVertex = o.firstVertex;
+        md.vertexCount = o.vertexCount;
+
+        md.faces.resize(o.faceCount);
+        for (uint32_t j = 0; j < o.faceCount; j++)
+            md.faces[j] = ReadFace(objectFaces.data + FaceInts * (o.firstFace + j));
+
+        md.meshlets.resize(o.meshletCount);
+        for (uint32_t j = 0; j < o.meshletCount; j++)
+        {
+            const MeshletRecord& r = meshlets.data[o.firstMeshlet + j];
+            Meshlet& m = md.meshlets[j];
+            m.firstFace = r.firstFace;
+            m.faceCount = r.faceCount;
+            m.bbMin = vec3(r.bbMin[0], r.bbMin[1], r.bbMin[2]);
+            m.bbMax = vec3(r.bbMax[0], r.bbMax[1], r.bbMax[2]);
+            m.center = vec3(r.center[0], r.center[1], r.center[2]);
+            m.radius = r.radius;
+            m.coneAxis = vec3(r.coneAxis[0], r.coneAxis[1], r.coneAxis[2]);
+            m.coneCutoff = r.coneCutoff;
+        }
+
+        md.material.reserve(o.materialCount);
+        for (uint32_t j = 0; j < o.materialCount; j++)
+            md.material.push_back(materialTable[objectMaterials.data[o.firstMaterial + j]]);
+        md.faceMaterial.assign(faceMaterials.data + o.firstFaceMaterial, faceMaterials.data + o.firstFaceMaterial + o.faceMaterialCount);
+
+        meshes.get_meshData().push_back(std::move(md));
+    }
+
+    meshes.set_normals(std::move(normal));
+    meshes.set_uvs(std::move(uv));
+    meshes.set_vertices(std::move(vertices));
+    meshes.build_indices();
+    meshes.build_batches();
+    meshes.build_bvh();
+    return true;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file MeshCache.hpp
+ * @brief Cache binaire (.r3dm) d'un Mesh déjà chargé, relu par projection mémoire sans parsing.
+ *
+ * Le fichier est écrit à côté de l'OBJ (scene.obj -> scene.obj.r3dm) après le premier chargement.
+ * Il contient un en-tête versionné suivi de tableaux alignés sur 64 octets : positions en SoA,
+ * UV, normales, indices de faces, plages par objet, meshlets et table des matériaux.
+ */
+
+#ifndef MeshCache_hpp
+#define MeshCache_hpp
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "Mesh.hpp"
+
+using namespace std;
+
+namespace Render3D
+{
+    /**
+     * @struct SourceStamp
+     * @brief Identité d'un fichier source au moment de l'écriture d'un cache
+     */
+    struct SourceStamp
+    {
+        uint64_t size;
+        int64_t mtime;
+        uint64_t hash;
+        uint32_t exists;
+        uint32_t hashed; // hash relevé (sinon 0, une date modifiée suffit à invalider)
+    };
+
+    /**
+     * @brief Empreinte 64 bits d'un bloc d'octets (non cryptographique)
+     */
+    uint64_t HashBytes(const char* data, size_t size);
+
+    /**
+     * @brief Relève la taille et la date de modification d'un fichier
+     * @param path Chemin du fichier (vide : fichier absent)
+     * @param withHash Calcule aussi l'empreinte du contenu (lecture du fichier entier)
+     */
+    SourceStamp StampFile(const string& path, bool withHash);
+
+    /**
+     * @brief Vérifie qu'un fichier n'a pas changé depuis son relevé
+     * @return true si la taille est identique et la date aussi, ou à défaut l'empreinte du contenu
+     *         quand le relevé en comporte une (sans empreinte, le fichier n'est pas relu)
+     */
+    bool SameSource(const SourceStamp& cached, const string& path);
+
+    /**
+     * @brief Chemin du MTL tel que LoadObj le résout à partir de son nom dans l'OBJ
+     */
+    string MtlPath(const string& mtlName);
+
+    /**
+     * @brief Écrit un Mesh chargé sous forme d'image autonome (même format que le cache, sans sources)
+     * @param out Flux binaire, positionné au début de l'image ; les sections sont alignées relativement à ce début
+     * @param meshes Mesh après build_meshlets()
+     */
+    void WriteMeshImage(ostream& out, Mesh& meshes);
+
+    /**
+     * @brief Relit une image de Mesh écrite par WriteMeshImage() ou SaveMeshCache()
+     * @param data Début de l'image (aligné sur 64 octets)
+     * @param size Taille de l'image en octets
+     * @param meshes Mesh à remplir (meshlets, lots et BVH compris)
+     * @return false si l'image est incohérente (meshes inchangé)
+     */
+    bool ReadMeshImage(const char* data, size_t size, Mesh& meshes);
+
+    /**
+     * @brief Charge un Mesh depuis le cache associé à un fichier OBJ
+     * @param objPath Chemin du fichier OBJ source
+     * @param meshes Mesh à remplir (meshlets et BVH compris)
+     * @return true si le cache existe, est valide et a été chargé ; false sinon (meshes inchangé)
+     *
+     * Le cache est valide si la version du format correspond et si l'OBJ et le MTL ont gardé
+     * leur taille et leur date de modification, ou, si la date a changé, leur empreinte de contenu.
+     * La variable d'environnement R3D_MESH_CACHE=0 désactive le cache.
+     */
+    bool LoadMeshCache(const string& objPath, Mesh& meshes);
+
+    /**
+     * @brief Écrit le cache d'un Mesh qui vient d'être chargé depuis un OBJ
+     * @param objPath Chemin du fichier OBJ source
+     * @param mtlName Nom du fichier MTL tel qu'il est référencé par l'OBJ (vide s'il n'y en a pas)
+     * @param meshes Mesh chargé, après get_Mesh()
+     *
+     * Un échec d'écriture (dossier en lecture seule...) est signalé sans interrompre le rendu.
+     */
+    void SaveMeshCache(const string& objPath, const string& mtlName, Mesh& meshes);
+};
+#endif /* MeshCache_hpp */
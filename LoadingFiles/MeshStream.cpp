@@ -0,0 +1,237 @@
+/**
+ * @file MeshStream.cpp
+ * @brief Écriture et lecture à la demande du stockage par blocs .r3ds.
+ */
+
+#include "MeshStream.hpp"
+#include "MeshCache.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+using namespace std;
+using namespace Render3D;
+
+namespace
+{
+    constexpr char StreamMagic[4] = { 'R', '3', 'D', 'S' };
+    constexpr uint32_t StreamVersion = 1;
+    constexpr size_t StreamAlignment = 64;
+    constexpr uint64_t StreamThresholdBytes = 2ull << 30;
+    constexpr size_t DefaultStreamBudgetMB = 1024;
+
+    struct StreamHeader
+    {
+        char magic[4];
+        uint32_t version;
+        SourceStamp obj;
+        SourceStamp mtl;
+        uint64_t chunkTable;   // offset de StreamChunk[chunkCount]
+        uint64_t mtlName;      // offset du nom du MTL, à la suite de la table
+        uint32_t chunkCount;
+        uint32_t mtlNameLength;
+    };
+
+    string StreamPath(const string& objPath)
+    {
+        return objPath + ".r3ds";
+    }
+
+    void WritePadding(ofstream& out)
+    {
+        const char zeros[StreamAlignment] = {};
+        const streamoff position = out.tellp();
+        const streamoff aligned = (position + StreamAlignment - 1) / StreamAlignment * StreamAlignment;
+        out.write(zeros, aligned - position);
+    }
+}
+
+bool Render3D::UseMeshStream(const string& objPath)
+{
+    const char* env = std::getenv("R3D_STREAM");
+    if (env != nullptr)
+        return strcmp(env, "0") != 0;
+    error_code ec;
+    const uintmax_t size = filesystem::file_size(objPath, ec);
+    return !ec && size > StreamThresholdBytes;
+}
+
+size_t Render3D::StreamBudgetBytes()
+{
+    const char* env = std::getenv("R3D_STREAM_BUDGET_MB");
+    const long megabytes = env != nullptr ? strtol(env, nullptr, 10) : 0;
+    return (megabytes > 0 ? static_cast<size_t>(megabytes) : DefaultStreamBudgetMB) << 20;
+}
+
+MeshStreamWriter::MeshStreamWriter(const string& objPath)
+    : _path(StreamPath(objPath)), _tmpPath(StreamPath(objPath) + ".tmp")
+{
+    _out.open(_tmpPath, ios::binary | ios::trunc);
+    if (!_out)
+        throw std::runtime_error("cannot write " + _tmpPath);
+    const StreamHeader header{};
+    _out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+MeshStreamWriter::~MeshStreamWriter()
+{
+    // Abandonné avant finish() : le fichier incomplet est supprimé.
+    if (_out.is_open())
+    {
+        _out.close();
+        error_code ec;
+        filesystem::remove(_tmpPath, ec);
+    }
+}
+
+void MeshStreamWriter::addChunk(Mesh& chunk)
+{
+    StreamChunk entry{};
+    const Vec3SoA& positions = chunk.get_vertices_soa();
+    if (positions.size() > 0)
+    {
+        vec3 bbMin = positions.get(0), bbMax = bbMin;
+        for (size_t k = 1; k < positions.size(); k++)
+        {
+            bbMin = min(bbMin, positions.get(k));
+            bbMax = max(bbMax, positions.get(k));
+        }
+        memcpy(entry.bbMin, &bbMin, sizeof(entry.bbMin));
+        memcpy(entry.bbMax, &bbMax, sizeof(entry.bbMax));
+    }
+    for (const MeshData& md : chunk.get_meshData())
+        entry.faceCount += static_cast<uint32_t>(md.faces.size());
+
+    WritePadding(_out);
+    entry.offset = static_cast<uint64_t>(_out.tellp());
+    WriteMeshImage(_out, chunk);
+    entry.size = static_cast<uint64_t>(_out.tellp()) - entry.offset;
+    if (!_out)
+        throw std::runtime_error("cannot write " + _tmpPath);
+    _chunks.push_back(entry);
+}
+
+void MeshStreamWriter::finish(const string& objPath, const string& mtlName)
+{
+    StreamHeader header{};
+    memcpy(header.magic, StreamMagic, sizeof(StreamMagic));
+    header.version = StreamVersion;
+    // L'OBJ n'est pas relu pour son empreinte : une date modifiée suffit à reconstruire le flux.
+    header.obj = StampFile(objPath, false);
+    header.mtl = StampFile(mtlName.empty() ? string() : MtlPath(mtlName), true);
+
+    WritePadding(_out);
+    header.chunkTable = static_cast<uint64_t>(_out.tellp());
+    header.chunkCount = static_cast<uint32_t>(_chunks.size());
+    _out.write(reinterpret_cast<const char*>(_chunks.data()), static_cast<streamsize>(_chunks.size() * sizeof(StreamChunk)));
+    header.mtlName = static_cast<uint64_t>(_out.tellp());
+    header.mtlNameLength = static_cast<uint32_t>(mtlName.size());
+    _out.write(mtlName.data(), static_cast<streamsize>(mtlName.size()));
+
+    _out.seekp(0);
+    _out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    _out.close();
+    if (!_out)
+        throw std::runtime_error("cannot write " + _tmpPath);
+
+    error_code ec;
+    filesystem::rename(_tmpPath, _path, ec);
+    if (ec)
+    {
+        filesystem::remove(_tmpPath, ec);
+        throw std::runtime_error("cannot rename " + _tmpPath);
+    }
+}
+
+MeshStream::MeshStream(size_t budgetBytes) : _budget(budgetBytes)
+{
+}
+
+bool MeshStream::open(const string& objPath)
+{
+    _chunks.clear();
+    _resident.clear();
+    _lastUse.clear();
+    _residentBytes = 0;
+    if (!_file.open(StreamPath(objPath)) || _file.size() < sizeof(StreamHeader))
+        return false;
+
+    StreamHeader header;
+    memcpy(&header, _file.data(), sizeof(StreamHeader));
+    const uint64_t size = _file.size();
+    if (memcmp(header.magic, StreamMagic, sizeof(StreamMagic)) != 0 || header.version != StreamVersion ||
+        header.chunkTable > size || header.chunkCount > (size - header.chunkTable) / sizeof(StreamChunk) ||
+        header.mtlName > size || header.mtlNameLength > size - header.mtlName)
+        return false;
+
+    const string mtlName(_file.data() + header.mtlName, header.mtlNameLength);
+    if (!SameSource(header.obj, objPath) || !SameSource(header.mtl, mtlName.empty() ? string() : MtlPath(mtlName)))
+        return false;
+
+    _chunks.resize(header.chunkCount);
+    memcpy(_chunks.data(), _file.data() + header.chunkTable, _chunks.size() * sizeof(StreamChunk));
+    for (const StreamChunk& c : _chunks)
+        if (c.offset % StreamAlignment != 0 || c.offset > size || c.size > size - c.offset)
+            return false;
+
+    _resident.resize(_chunks.size());
+    _lastUse.assign(_chunks.size(), 0);
+    return true;
+}
+
+size_t MeshStream::get_chunkCount() const
+{
+    return _chunks.size();
+}
+
+const StreamChunk& MeshStream::get_chunk(size_t i) const
+{
+    return _chunks[i];
+}
+
+void MeshStream::evict(size_t i)
+{
+    _residentBytes -= _resident[i]->get_memoryUsage();
+    _resident[i].reset();
+}
+
+Mesh& MeshStream::acquire(size_t i)
+{
+    _lastUse[i] = ++_clock;
+    if (_resident[i])
+        return *_resident[i];
+
+    // Place pour le bloc (estimée par la taille de son image) : libération des moins récemment utilisés.
+    while (_residentBytes + _chunks[i].size > _budget)
+    {
+        size_t oldest = _resident.size();
+        for (size_t k = 0; k < _resident.size(); k++)
+            if (_resident[k] && (oldest == _resident.size() || _lastUse[k] < _lastUse[oldest]))
+                oldest = k;
+        if (oldest == _resident.size())
+            break;
+        evict(oldest);
+    }
+
+    unique_ptr<Mesh> chunk = make_unique<Mesh>();
+    if (!ReadMeshImage(_file.data() + _chunks[i].offset, _chunks[i].size, *chunk))
+        throw std::runtime_error("corrupted chunk " + to_string(i) + " in geometry stream");
+    // Le bloc est recopié dans le Mesh : ses pages dans la projection peuvent être rendues.
+    _file.discard(_chunks[i].offset, _chunks[i].size);
+
+    _residentBytes += chunk->get_memoryUsage();
+    _loadCount++;
+    _resident[i] = std::move(chunk);
+    return *_resident[i];
+}
+
+size_t MeshStream::get_residentBytes() const
+{
+    return _residentBytes;
+}
+
+size_t MeshStream::get_loadCount() const
+{
+    return _loadCount;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file MeshStream.hpp
+ * @brief Stockage sur disque (.r3ds) d'un OBJ découpé en blocs spatiaux, chargés à la demande au rendu.
+ *
+ * Pour un OBJ trop gros pour la mémoire, LoadObj::buildStream() écrit à côté de lui
+ * (scene.obj -> scene.obj.r3ds) une suite de blocs : chacun regroupe les faces d'une cellule
+ * d'une grille régulière et est une image de Mesh autonome (WriteMeshImage), avec ses propres
+ * sommets, meshlets et matériaux. Une table en fin de fichier donne la boîte englobante de chaque bloc.
+ * Au rendu, seuls les blocs qui coupent le frustum sont chargés, dans la limite d'un budget mémoire.
+ */
+
+#ifndef MeshStream_hpp
+#define MeshStream_hpp
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Mesh.hpp"
+#include "../Tools/MappedFile.hpp"
+
+using namespace std;
+
+namespace Render3D
+{
+    /**
+     * @struct StreamChunk
+     * @brief Entrée de la table des blocs d'un fichier .r3ds
+     */
+    struct StreamChunk
+    {
+        float bbMin[3];
+        float bbMax[3];
+        uint32_t faceCount;
+        uint32_t padding;
+        uint64_t offset; // début de l'image du bloc dans le fichier (aligné sur 64 octets)
+        uint64_t size;   // taille de l'image en octets
+    };
+
+    /**
+     * @brief Indique si un OBJ doit être rendu par blocs plutôt que chargé en entier
+     * @param objPath Chemin du fichier OBJ
+     *
+     * La variable d'environnement R3D_STREAM=1 force le mode par blocs, R3D_STREAM=0 l'interdit ;
+     * sinon il est choisi pour les OBJ de plus de 2 Go.
+     */
+    bool UseMeshStream(const string& objPath);
+
+    /**
+     * @brief Budget mémoire des blocs résidents, en octets
+     *
+     * Lu dans R3D_STREAM_BUDGET_MB (1024 Mo par défaut).
+     */
+    size_t StreamBudgetBytes();
+
+    /**
+     * @class MeshStreamWriter
+     * @brief Écrit un fichier .r3ds bloc par bloc
+     *
+     * Le fichier est écrit sous un nom temporaire et renommé par finish() : un flux n'est jamais lu à moitié écrit.
+     */
+    class MeshStreamWriter
+    {
+        private:
+            string _path;
+            string _tmpPath;
+            ofstream _out;
+            vector<StreamChunk> _chunks;
+
+        public:
+            /**
+             * @brief Ouvre le fichier temporaire du flux associé à un OBJ
+             * @throw runtime_error si le fichier ne peut pas être créé
+             */
+            explicit MeshStreamWriter(const string& objPath);
+            ~MeshStreamWriter();
+
+            /**
+             * @brief Ajoute un bloc
+             * @param chunk Mesh du bloc après build_meshlets() (positions en espace monde)
+             */
+            void addChunk(Mesh& chunk);
+
+            /**
+             * @brief Écrit la table des blocs et l'identité des sources, puis renomme le fichier
+             * @param objPath Chemin du fichier OBJ source
+             * @param mtlName Nom du fichier MTL référencé par l'OBJ (vide s'il n'y en a pas)
+             * @throw runtime_error en cas d'échec d'écriture
+             */
+            void finish(const string& objPath, const string& mtlName);
+    };
+
+    /**
+     * @class MeshStream
+     * @brief Fichier .r3ds projeté en mémoire, dont les blocs sont chargés à la demande
+     *
+     * Les blocs chargés restent résidents d'une image à l'autre ; quand leur taille cumulée
+     * dépasse le budget, les moins récemment utilisés sont libérés.
+     */
+    class MeshStream
+    {
+        private:
+            MappedFile _file;
+            vector<StreamChunk> _chunks;
+            vector<unique_ptr<Mesh>> _resident;
+            vector<uint64_t> _lastUse;
+            uint64_t _clock = 0;
+            size_t _budget;
+            size_t _residentBytes = 0;
+            size_t _loadCount = 0;
+
+            void evict(size_t i);
+
+        public:
+            explicit MeshStream(size_t budgetBytes);
+
+            /**
+             * @brief Ouvre le flux associé à un OBJ
+             * @return false si le flux n'existe pas, est incohérent ou si l'OBJ ou le MTL ont changé depuis son écriture
+             */
+            bool open(const string& objPath);
+
+            size_t get_chunkCount() const;
+            const StreamChunk& get_chunk(size_t i) const;
+
+            /**
+             * @brief Renvoie le Mesh d'un bloc, chargé depuis le fichier s'il n'est pas résident
+             * @note La référence reste valide jusqu'au prochain appel (qui peut libérer le bloc)
+             * @throw runtime_error si l'image du bloc est incohérente
+             */
+            Mesh& acquire(size_t i);
+
+            /// Mémoire occupée par les blocs résidents, en octets.
+            size_t get_residentBytes() const;
+
+            /// Nombre de blocs lus depuis le fichier depuis l'ouverture.
+            size_t get_loadCount() const;
+    };
+};
+#endif /* MeshStream_hpp */
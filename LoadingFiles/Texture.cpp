@@ -1,57 +1,78 @@
 #include "Texture.h"
-#include "../Tools/jpeg.hpp"
+#include "../Tools/BlockCompression.hpp"
+#include <algorithm>
 #include <iostream>
 using namespace Render3D;
 
-Textures::Textures(string pathTexture) {
+Textures::Textures(string pathTexture, float pixelsPerUv) {
 	_pathTexture = pathTexture;
 	_isLoaded.store(false);
 	_height = 0;
 	_width = 0;
 	_image = nullptr;
-	_u = 0.0f;
-	_v = 0.0f;
+	_format = TextureFormat::Rgb8;
+	_texel[0] = _texel[1] = _texel[2] = 0;
 	if (pathTexture.empty() == false)
 	{
-		loadTexture();
+		loadTexture(pixelsPerUv);
 	}
 }
 
 Textures::~Textures() {
-	delete[] _image;
 }
 
-void Textures::loadTexture()
+void Textures::loadTexture(float pixelsPerUv)
 {
-
-	bool toto = readJPEG(_pathTexture.c_str(), _image, _width, _height);
-	_isLoaded.store(toto);
+	// Décodée une seule fois pour toute la scène, le plus souvent déjà prête (PrefetchTextures),
+	// à la résolution la plus basse qui couvre encore l'empreinte à l'écran.
+	if (UseVirtualTexture(_pathTexture))
+	{
+		_isLoaded.store(_virtual.open(_pathTexture, pixelsPerUv));
+		_width = _virtual.width();
+		_height = _virtual.height();
+		return;
+	}
+	TextureCache& cache = GetTextureCache();
+	_source = cache.get(_pathTexture, cache.selectLevel(_pathTexture, pixelsPerUv), ColorTextureFormat());
+	_image = _source->pixels;
+	_format = _source->format;
+	_width = _source->width;
+	_height = _source->height;
+	_isLoaded.store(_source->loaded);
 }
 
 void Textures::setPixel(float u, float v) {
-	_u = u;
-	_v = v;
+	int x = static_cast<int>(u * (_width-1));
+	int y = static_cast<int>(v * (_height-1));
+	int index = y * _height + x;
+	if (_virtual.is_open())
+	{
+		index = std::clamp(index, 0, _width * _height - 1);
+		_virtual.fetch(index % _width, index / _width, _texel);
+		return;
+	}
+	if (_format == TextureFormat::BC1)
+	{
+		// Même texel que dans l'image RGB : rang index, soit (index % largeur, index / largeur).
+		index = std::clamp(index, 0, _width * _height - 1);
+		DecodeBC1Texel(_image, _width, index % _width, index / _width, _texel);
+		return;
+	}
+	_texel[0] = _image[3 * index];
+	_texel[1] = _image[3 * index + 1];
+	_texel[2] = _image[3 * index + 2];
 }
 
 int Textures::getRed() {
-	int x = static_cast<int>(_u * (_width-1));
-	int y = static_cast<int>(_v * (_height-1));
-	int index = 3 * (y * _height + x);
-	return  _image[index];
+	return _texel[0];
 }
 
 int Textures::getGreen() {
-	int x = static_cast<int>(_u * (_width-1));
-	int y = static_cast<int>(_v * (_height-1));
-	int index = 3 * (y * _height + x);
-	return _image[index + 1];
+	return _texel[1];
 }
 
 int Textures::getBlue() {
-	int x = static_cast<int>(_u * (_width-1));
-	int y = static_cast<int>(_v * (_height-1));
-	int index = 3 * (y * _height + x);
-	return _image[index + 2];
+	return _texel[2];
 }
 
 bool Textures::getLoaded() {
@@ -2,6 +2,9 @@
 #include <string>
 #include <atomic>
 #include <mutex>
+#include <memory>
+#include "TextureCache.hpp"
+#include "VirtualTexture.hpp"
 
 using namespace std;
 namespace Render3D
@@ -12,15 +15,17 @@ namespace Render3D
 		int _width;
 		int _height;
 		std::atomic<bool> _isLoaded;
-		unsigned char* _image;
-		float _u;
-		float _v;
+		shared_ptr<const TextureImage> _source; // image partagée du cache de textures
+		const unsigned char* _image;
+		TextureFormat _format;
+		VirtualTextureView _virtual; // très grande texture : tuiles chargées à la demande
+		unsigned char _texel[3]; // couleur du dernier texel choisi par setPixel
 		std::mutex _loadMutex;
 
 	public:
-		Textures(string pathTexture);
+		Textures(string pathTexture, float pixelsPerUv = FullResolution);
 		~Textures();
-		void loadTexture();
+		void loadTexture(float pixelsPerUv = FullResolution);
 		void setPixel(float u, float v);
 		int getRed();
 		int getGreen();
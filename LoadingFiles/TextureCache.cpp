@@ -0,0 +1,218 @@
+/**
+ * @file TextureCache.cpp
+ * @brief Pool de décodage et table partagée des textures.
+ */
+
+#include "TextureCache.hpp"
+#include "DecodedTextureCache.hpp"
+#include "VirtualTexture.hpp"
+#include "../Tools/jpeg.hpp"
+#include "../Tools/MappedFile.hpp"
+#include "../Tools/BlockCompression.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+using namespace Render3D;
+
+namespace
+{
+    shared_ptr<const TextureImage> Compress(const TextureImage& rgb, TextureFormat format)
+    {
+        shared_ptr<TextureImage> image = make_shared<TextureImage>();
+        image->decoded = format == TextureFormat::BC1 ? CompressBC1(rgb.pixels, rgb.width, rgb.height) : CompressBC5(rgb.pixels, rgb.width, rgb.height);
+        image->pixels = image->decoded.get();
+        image->format = format;
+        image->width = rgb.width;
+        image->height = rgb.height;
+        image->level = rgb.level;
+        image->loaded = true;
+        return image;
+    }
+
+    shared_ptr<const TextureImage> DecodeTexture(const string& path, int level, TextureFormat format)
+    {
+        shared_ptr<TextureImage> image = make_shared<TextureImage>();
+        if (!LoadDecodedTexture(path, level, *image))
+        {
+            // Relevé pris avant le décodage : un JPEG modifié pendant celui-ci invalide l'entrée écrite.
+            const SourceStamp source = StampFile(path, true);
+            unsigned char* pixels = nullptr;
+            image->loaded = readJPEG(path.c_str(), pixels, image->width, image->height, 1 << level);
+            image->decoded.reset(pixels);
+            image->pixels = pixels;
+            image->level = level;
+            if (image->loaded)
+                SaveDecodedTexture(path, source, *image);
+        }
+        // L'image RGB n'est gardée que le temps de la compression.
+        if (format != TextureFormat::Rgb8 && image->loaded)
+            return Compress(*image, format);
+        return image;
+    }
+
+    bool CompressionEnabled()
+    {
+        const char* env = std::getenv("R3D_TEXTURE_COMPRESSION");
+        return env != nullptr && strcmp(env, "0") != 0;
+    }
+}
+
+TextureCache::TextureCache() : _workers(max(1u, std::thread::hardware_concurrency()))
+{
+    // Construit avant le cache, le pool de textures virtuelles est détruit après lui :
+    // les constructions de fichiers de tuiles encore en file sur les workers le trouvent intact.
+    GetVirtualTexturePool();
+}
+
+TextureCache::~TextureCache()
+{
+    // Les décodages encore en file sont abandonnés : plus personne n'attendra leur image.
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry : _entries)
+        for (const auto& levels : entry.second.level)
+            for (const shared_ptr<Decode>& decode : levels)
+                if (decode)
+                    decode->claim();
+}
+
+shared_ptr<TextureCache::Decode> TextureCache::MakeDecode(const string& path, int level, TextureFormat format)
+{
+    shared_ptr<Decode> decode = make_shared<Decode>();
+    decode->task = packaged_task<shared_ptr<const TextureImage>()>([path, level, format] { return DecodeTexture(path, level, format); });
+    decode->image = decode->task.get_future().share();
+    return decode;
+}
+
+void TextureCache::warm(const string& path)
+{
+    if (path.empty())
+        return;
+    // Texture virtuelle : jamais décodée en entier, seul son fichier de tuiles est préparé en arrière-plan.
+    if (UseVirtualTexture(path))
+    {
+        _workers.enqueue([path] { GetVirtualTexturePool().open(path); });
+        return;
+    }
+    // Lecture anticipée du fichier par le noyau, et de l'en-tête dont selectLevel aura besoin.
+    MappedFile::prefetch(path);
+    _workers.enqueue([this, path] {
+        int width, height;
+        imageSize(path, width, height);
+    });
+}
+
+void TextureCache::prefetch(const string& path, int level, TextureFormat format)
+{
+    if (path.empty() || UseVirtualTexture(path))
+        return;
+    shared_ptr<Decode> decode;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        shared_ptr<Decode>* levels = _entries[path].level[static_cast<int>(format)];
+        for (int l = level; l >= 0; l--)
+            if (levels[l])
+                return;
+        decode = levels[level] = MakeDecode(path, level, format);
+    }
+    _workers.enqueue([decode] {
+        if (decode->claim())
+            decode->task();
+    });
+}
+
+bool TextureCache::imageSize(const string& path, int& width, int& height)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        width = _entries[path].width;
+        height = _entries[path].height;
+    }
+    if (width < 0)
+    {
+        // En-tête seul : la taille est connue sans décoder l'image.
+        if (!readJPEGSize(path.c_str(), width, height))
+            width = height = 0;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries[path].width = width;
+        _entries[path].height = height;
+    }
+    return width > 0;
+}
+
+int TextureCache::selectLevel(const string& path, float pixelsPerUv)
+{
+    if (pixelsPerUv >= FullResolution)
+        return 0;
+
+    int width, height;
+    imageSize(path, width, height);
+
+    // Texels par unité de uv à un niveau : la taille de l'image à ce niveau.
+    int level = 0;
+    while (level + 1 < TextureLevels && static_cast<float>(min(width, height) >> (level + 1)) >= pixelsPerUv)
+        level++;
+    return level;
+}
+
+shared_ptr<const TextureImage> TextureCache::get(const string& path, int level, TextureFormat format)
+{
+    shared_ptr<Decode> decode;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        shared_ptr<Decode>* levels = _entries[path].level[static_cast<int>(format)];
+        // Un décodage commencé (ou fini) à un niveau au moins aussi fin suffit.
+        for (int l = level; l >= 0 && !decode; l--)
+            if (levels[l] && levels[l]->started)
+                decode = levels[l];
+        if (!decode)
+        {
+            // Les décodages en file plus fins que nécessaire sont abandonnés au profit du niveau demandé.
+            for (int l = 0; l < level; l++)
+                if (levels[l] && levels[l]->claim())
+                    levels[l].reset();
+            if (!levels[level])
+                levels[level] = MakeDecode(path, level, format);
+            decode = levels[level];
+        }
+    }
+    if (decode->claim())
+        decode->task();
+    return decode->image.get();
+}
+
+TextureCache& Render3D::GetTextureCache()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+TextureFormat Render3D::ColorTextureFormat()
+{
+    return CompressionEnabled() ? TextureFormat::BC1 : TextureFormat::Rgb8;
+}
+
+TextureFormat Render3D::NormalTextureFormat()
+{
+    return CompressionEnabled() ? TextureFormat::BC5 : TextureFormat::Rgb8;
+}
+
+void Render3D::WarmTextures(const MaterialProperty& material)
+{
+    TextureCache& cache = GetTextureCache();
+    cache.warm(material.pathTexture);
+    cache.warm(material.pathTextureBump);
+    cache.warm(material.pathTextureDisp);
+}
+
+void Render3D::PrefetchTextures(const MaterialProperty& material, float pixelsPerUv)
+{
+    TextureCache& cache = GetTextureCache();
+    if (!material.pathTexture.empty())
+        cache.prefetch(material.pathTexture, cache.selectLevel(material.pathTexture, pixelsPerUv), ColorTextureFormat());
+    if (!material.pathTextureBump.empty())
+        cache.prefetch(material.pathTextureBump, cache.selectLevel(material.pathTextureBump, pixelsPerUv), NormalTextureFormat());
+    if (!material.pathTextureDisp.empty())
+        cache.prefetch(material.pathTextureDisp, cache.selectLevel(material.pathTextureDisp, pixelsPerUv));
+}
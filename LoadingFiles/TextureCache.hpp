@@ -0,0 +1,171 @@
+/**
+ * @file TextureCache.hpp
+ * @brief Décodage asynchrone et partagé des textures JPEG d'une scène.
+ *
+ * Rien n'est lu au chargement de la scène : après le culling d'une image, les fichiers des seuls
+ * matériaux qui gardent un meshlet visible sont lus à l'avance (contenu et en-tête JPEG) ; dès que les
+ * sommets d'un objet sont projetés, les textures de ses lots visibles sont confiées à un pool de threads
+ * au niveau que demande leur empreinte à l'écran, et leur décodage avance pendant la rasterisation des
+ * lots précédents. Un lot de faces n'attend que les textures de son matériau, et chaque fichier n'est
+ * décodé qu'une seule fois par niveau de résolution quel que soit le nombre de lots qui l'utilisent.
+ *
+ * Une texture plus fine que son empreinte à l'écran est décodée à 1/2, 1/4 ou 1/8 de sa taille
+ * (mise à l'échelle DCT de libjpeg) ; un niveau plus fin n'est décodé que lorsqu'une image le demande.
+ *
+ * Chaque niveau décodé est conservé sur disque (DecodedTextureCache.hpp) : aux exécutions suivantes,
+ * il est projeté en mémoire au lieu d'être décodé.
+ *
+ * Avec R3D_TEXTURE_COMPRESSION=1, les textures de couleur sont gardées en mémoire en blocs BC1
+ * et les normal maps en blocs BC5 (Tools/BlockCompression.hpp), décompressés texel par texel à l'échantillonnage.
+ */
+
+#ifndef TextureCache_hpp
+#define TextureCache_hpp
+
+#include <atomic>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Mesh.hpp"
+#include "../Tools/MappedFile.hpp"
+#include "../Tools/ThreadPool.hpp"
+
+using namespace std;
+
+namespace Render3D
+{
+    /// Niveaux de résolution décodables : 1, 1/2, 1/4 et 1/8 de la taille du fichier.
+    constexpr int TextureLevels = 4;
+
+    /// Densité demandée quand l'empreinte à l'écran est inconnue : pleine résolution.
+    constexpr float FullResolution = numeric_limits<float>::max();
+
+    /// Représentation en mémoire d'une texture décodée.
+    enum class TextureFormat
+    {
+        Rgb8, // 3 octets par texel
+        BC1,  // couleur, 0,5 octet par texel
+        BC5   // normal map (x et y), 1 octet par texel
+    };
+    constexpr int TextureFormats = 3;
+
+    /**
+     * @struct TextureImage
+     * @brief Image décodée, lignes rangées de bas en haut : texels RGB 8 bits ou blocs compressés selon format
+     */
+    struct TextureImage
+    {
+        const unsigned char* pixels = nullptr; // dans decoded, ou dans mapping pour une image relue du cache sur disque
+        TextureFormat format = TextureFormat::Rgb8;
+        unique_ptr<unsigned char[]> decoded;
+        MappedFile mapping;
+        int width = 0;
+        int height = 0;
+        int level = 0;       // taille divisée par 2^level
+        bool loaded = false; // false si le fichier n'a pas pu être lu
+    };
+
+    /**
+     * @class TextureCache
+     * @brief Table des textures décodées ou en cours de décodage, indexée par chemin
+     */
+    class TextureCache
+    {
+        private:
+            // Décodage démarré une seule fois, par un thread du pool ou par le premier thread qui attend l'image.
+            struct Decode
+            {
+                packaged_task<shared_ptr<const TextureImage>()> task;
+                shared_future<shared_ptr<const TextureImage>> image;
+                atomic<bool> started{ false };
+
+                bool claim() { return !started.exchange(true); }
+            };
+
+            struct Entry
+            {
+                shared_ptr<Decode> level[TextureFormats][TextureLevels]; // décodages lancés ou en file, par format et niveau
+                int width = -1;                          // taille à pleine résolution (-1 : en-tête pas encore lu)
+                int height = -1;
+            };
+
+            std::mutex _mutex;
+            unordered_map<string, Entry> _entries;
+            ThreadPool _workers; // détruit en premier : les threads s'arrêtent avant la table
+
+            static shared_ptr<Decode> MakeDecode(const string& path, int level, TextureFormat format);
+
+        public:
+            TextureCache();
+            ~TextureCache();
+
+            /**
+             * @brief Prépare une texture sans la décoder : lecture anticipée du fichier et de son en-tête en arrière-plan
+             * @param path Chemin du fichier JPEG (vide : ignoré)
+             *
+             * Une texture virtuelle voit son fichier de tuiles ouvert (ou construit) en arrière-plan.
+             */
+            void warm(const string& path);
+
+            /**
+             * @brief Lance le décodage d'une texture en arrière-plan, sauf s'il en existe déjà un au moins aussi fin
+             * @param path Chemin du fichier JPEG (vide : ignoré)
+             * @param level Niveau de résolution (0 : pleine résolution)
+             * @param format Représentation en mémoire de l'image
+             */
+            void prefetch(const string& path, int level, TextureFormat format = TextureFormat::Rgb8);
+
+            /**
+             * @brief Niveau de résolution suffisant pour une empreinte à l'écran
+             * @param path Chemin du fichier JPEG
+             * @param pixelsPerUv Pixels de l'écran par unité de coordonnée de texture (FullResolution : inconnue)
+             * @return Le niveau le plus grossier qui garde au moins un texel par pixel
+             */
+            int selectLevel(const string& path, float pixelsPerUv);
+
+            /**
+             * @brief Taille d'une texture à pleine résolution, lue une seule fois dans l'en-tête du JPEG
+             * @return false si le fichier ne peut pas être lu
+             */
+            bool imageSize(const string& path, int& width, int& height);
+
+            /**
+             * @brief Renvoie une texture décodée au moins aussi fine que le niveau demandé
+             * @param path Chemin du fichier JPEG
+             * @param level Niveau de résolution (0 : pleine résolution)
+             * @param format Représentation en mémoire de l'image
+             *
+             * Un décodage déjà commencé à un niveau suffisant est attendu. Sinon, le décodage en file
+             * plus fin que nécessaire est abandonné et le niveau demandé est décodé sur le thread appelant.
+             */
+            shared_ptr<const TextureImage> get(const string& path, int level = 0, TextureFormat format = TextureFormat::Rgb8);
+    };
+
+    /// Cache de textures du processus.
+    TextureCache& GetTextureCache();
+
+    /// Format des textures de couleur (map_Kd) : BC1 si R3D_TEXTURE_COMPRESSION=1, RGB sinon.
+    TextureFormat ColorTextureFormat();
+
+    /// Format des normal maps (map_Bump) : BC5 si R3D_TEXTURE_COMPRESSION=1, RGB sinon.
+    TextureFormat NormalTextureFormat();
+
+    /**
+     * @brief Prépare les textures d'un matériau (map_Kd, map_Bump et disp) sans les décoder
+     *
+     * Appelé par le rendu pour les matériaux des lots visibles après culling, avant que leur empreinte
+     * à l'écran ne soit connue : aucun niveau de résolution n'est choisi ici.
+     */
+    void WarmTextures(const MaterialProperty& material);
+
+    /**
+     * @brief Lance le décodage des textures d'un matériau au niveau que demande son empreinte à l'écran
+     * @param material Matériau du lot
+     * @param pixelsPerUv Pixels de l'écran par unité de coordonnée de texture (FullResolution : inconnue)
+     */
+    void PrefetchTextures(const MaterialProperty& material, float pixelsPerUv);
+};
+#endif /* TextureCache_hpp */
@@ -1,5 +1,7 @@
 #include "TextureNormalMap.h"
+#include "../Tools/BlockCompression.hpp"
 //#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
 #include <iostream>
 
 using namespace Render3D;
@@ -7,6 +9,7 @@ using namespace Render3D;
 TextureNormalMap::TextureNormalMap()
 {
 	_image = nullptr;
+	_format = TextureFormat::Rgb8;
 	_width = 0;
 	_height = 0;
 	_isLoaded.store(false);
@@ -19,9 +22,10 @@ TextureNormalMap::TextureNormalMap()
 	normal = {};
 }
 
-TextureNormalMap::TextureNormalMap(string pathTexture) {
+TextureNormalMap::TextureNormalMap(string pathTexture, float pixelsPerUv) {
 	_pathTextureBump = pathTexture;
 	_image = nullptr;
+	_format = TextureFormat::Rgb8;
 	_width = 0;
 	_height = 0;
 	_isLoaded = false;
@@ -34,17 +38,29 @@ TextureNormalMap::TextureNormalMap(string pathTexture) {
 	normal = {};
 	if (pathTexture.empty() == false)
 	{
-		loadTexture();
+		loadTexture(pixelsPerUv);
 	}
 }
 
 TextureNormalMap::~TextureNormalMap() {
-	delete[] _image;
 }
 
-void TextureNormalMap::loadTexture()
+void TextureNormalMap::loadTexture(float pixelsPerUv)
 {
-	_isLoaded.store(readJPEG(_pathTextureBump.c_str(), _image, _width, _height));
+	if (UseVirtualTexture(_pathTextureBump))
+	{
+		_isLoaded.store(_virtual.open(_pathTextureBump, pixelsPerUv));
+		_width = _virtual.width();
+		_height = _virtual.height();
+		return;
+	}
+	TextureCache& cache = GetTextureCache();
+	_source = cache.get(_pathTextureBump, cache.selectLevel(_pathTextureBump, pixelsPerUv), NormalTextureFormat());
+	_image = _source->pixels;
+	_format = _source->format;
+	_width = _source->width;
+	_height = _source->height;
+	_isLoaded.store(_source->loaded);
 }
 
 void TextureNormalMap::setPixel(float u, float v) {
@@ -53,12 +69,38 @@ void TextureNormalMap::setPixel(float u, float v) {
 	int y = static_cast<int>(v * (_height-1));
 	int index = 3 * (y * _height + x);
 
+	if (_virtual.is_open())
+	{
+		unsigned char rgb[3];
+		index = std::clamp(index / 3, 0, _width * _height - 1);
+		_virtual.fetch(index % _width, index / _width, rgb);
+		_normal.x = rgb[0];
+		_normal.y = rgb[1];
+		_normal.z = rgb[2];
+		return;
+	}
+
+	if (_format == TextureFormat::BC5)
+	{
+		// Seuls x et y sont stockés : z est reconstruit pour une normale unitaire tournée vers l'extérieur.
+		unsigned char xy[2];
+		index = std::clamp(index / 3, 0, _width * _height - 1);
+		DecodeBC5Texel(_image, _width, index % _width, index / _width, xy);
+		float nx = (xy[0] / 255.0f) * 2.0f - 1.0f;
+		float ny = (xy[1] / 255.0f) * 2.0f - 1.0f;
+		float nz = sqrt(std::max(0.0f, 1.0f - nx * nx - ny * ny));
+		_normal.x = xy[0];
+		_normal.y = xy[1];
+		_normal.z = (nz + 1.0f) * 0.5f * 255.0f;
+		return;
+	}
+
 	_normal.x = _image[index];
 	_normal.y = _image[index + 1];
 	_normal.z = _image[index + 2];
 }
 
-vec3 TextureNormalMap::GetPixelNormal(Face& f, vec3 a, vec3 b, vec3 c, vector<vec2>& uvs, vec3 weight, mat3x3 w, bool parallax) {
+vec3 TextureNormalMap::GetPixelNormal(const Face& f, vec3 a, vec3 b, vec3 c, const vector<vec2>& uvs, vec3 weight, mat3x3 w, bool parallax) {
 
 	normal.x = ((_normal.x / 255.0f) * 2.0f) -1.0f;
 	normal.y = ((_normal.y / 255.0f) * 2.0f) -1.0f;
@@ -75,7 +117,7 @@ vec3 TextureNormalMap::GetPixelNormal(Face& f, vec3 a, vec3 b, vec3 c, vector<ve
 	return normal;
 }
 
-mat3x3 TextureNormalMap::getTBN(Face& f, vec3 a, vec3 b, vec3 c, vector<vec2>& uvs, vec3 weight, mat3x3 w) {
+mat3x3 TextureNormalMap::getTBN(const Face& f, vec3 a, vec3 b, vec3 c, const vector<vec2>& uvs, vec3 weight, mat3x3 w) {
 	return preCompute(f, a,  b, c, uvs, weight, w);
 }
 
@@ -83,61 +125,44 @@ bool TextureNormalMap::getLoaded() {
 	return _isLoaded.load();
 }
 
-mat3x3 TextureNormalMap::preCompute(Face& f, vec3 a, vec3 b, vec3 c, vector<vec2>& uvs, vec3 normal, mat3x3 w) {
-	UV1 = uvs[f.B.IndiceTexCoords - 1] - uvs[f.A.IndiceTexCoords - 1];
-	UV2 = uvs[f.C.IndiceTexCoords - 1] - uvs[f.A.IndiceTexCoords - 1];
+mat3x3 TextureNormalMap::preCompute(const Face& f, vec3 a, vec3 b, vec3 c, const vector<vec2>& uvs, vec3 normal, mat3x3 w) {
+	UV1 = uvs[f.B.IndiceVertices - 1] - uvs[f.A.IndiceVertices - 1];
+	UV2 = uvs[f.C.IndiceVertices - 1] - uvs[f.A.IndiceVertices - 1];
 
 	edge1 = b - a;
 	edge2 = c - a;
 
 	float coef = 1.0f / ((UV1.x * UV2.y) - (UV2.x * UV1.y));
 
-	computeTangent(f, coef);
-	computeBiTangent(f, coef);
-
 	vec3 T;
 	vec3 B;
 	vec3 N;
 
 	N = normalize(cross(edge1, edge2));
 
-	//TransformVectorByMatrix4x4(f.A.Tangent, w, T);
-	T = w * f.A.Tangent ;
+	// Tangente et bitangente sont constantes sur le triangle : calculées ici, jamais stockées dans la face.
+	T = w * computeTangent(coef);
 	T = normalize(T);
 
-	//TransformVectorByMatrix4x4(f.A.Bitangent, w, B);
-	B = w * f.A.Bitangent;
+	B = w * computeBiTangent(coef);
 	B = normalize(B);
 
 	return mat3(T, B, N);
 }
-void TextureNormalMap::computeTangent(Face& f, float coef) {
-	f.A.Tangent.x = coef * ((UV2.y * edge1.x) - (UV1.y * edge2.x));
-	f.B.Tangent.x = coef * ((UV2.y * edge1.x) - (UV1.y * edge2.x));
-	f.C.Tangent.x = coef * ((UV2.y * edge1.x) - (UV1.y * edge2.x));
-
-	f.A.Tangent.y = coef * ((UV2.y * edge1.y) - (UV1.y * edge2.y));
-	f.B.Tangent.y = coef * ((UV2.y * edge1.y) - (UV1.y * edge2.y));
-	f.C.Tangent.y = coef * ((UV2.y * edge1.y) - (UV1.y * edge2.y));
-
-
-	f.A.Tangent.z = coef * ((UV2.y * edge1.z) - (UV1.y * edge2.z));
-	f.B.Tangent.z = coef * ((UV2.y * edge1.z) - (UV1.y * edge2.z));
-	f.C.Tangent.z = coef * ((UV2.y * edge1.z) - (UV1.y * edge2.z));
+vec3 TextureNormalMap::computeTangent(float coef) const {
+	vec3 tangent;
+	tangent.x = coef * ((UV2.y * edge1.x) - (UV1.y * edge2.x));
+	tangent.y = coef * ((UV2.y * edge1.y) - (UV1.y * edge2.y));
+	tangent.z = coef * ((UV2.y * edge1.z) - (UV1.y * edge2.z));
+	return tangent;
 }
 
-void TextureNormalMap::computeBiTangent(Face& f, float coef) {
-	f.A.Bitangent.x = coef * (-(UV2.x * edge1.x) + (UV1.x * edge2.x));
-	f.B.Bitangent.x = coef * (-(UV2.x * edge1.x) + (UV1.x * edge2.x));
-	f.C.Bitangent.x = coef * (-(UV2.x * edge1.x) + (UV1.x * edge2.x));
-
-	f.A.Bitangent.y = coef * (-(UV2.x * edge1.y) + (UV1.x * edge2.y));
-	f.B.Bitangent.y = coef * (-(UV2.x * edge1.y) + (UV1.x * edge2.y));
-	f.C.Bitangent.y = coef * (-(UV2.x * edge1.y) + (UV1.x * edge2.y));
-
-	f.A.Bitangent.z = coef * (-(UV2.x * edge1.z) + (UV1.x * edge2.z));
-	f.B.Bitangent.z = coef * (-(UV2.x * edge1.z) + (UV1.x * edge2.z));
-	f.C.Bitangent.z = coef * (-(UV2.x * edge1.z) + (UV1.x * edge2.z));
+vec3 TextureNormalMap::computeBiTangent(float coef) const {
+	vec3 bitangent;
+	bitangent.x = coef * (-(UV2.x * edge1.x) + (UV1.x * edge2.x));
+	bitangent.y = coef * (-(UV2.x * edge1.y) + (UV1.x * edge2.y));
+	bitangent.z = coef * (-(UV2.x * edge1.z) + (UV1.x * edge2.z));
+	return bitangent;
 }
 
 vec3 TextureNormalMap::getNormal() const{
@@ -1,9 +1,11 @@
 #pragma once
 #include <string>
-#include "../Tools/jpeg.hpp"
 #include "../LoadingFiles/Mesh.hpp"
 #include <atomic>
 #include <mutex>
+#include <memory>
+#include "TextureCache.hpp"
+#include "VirtualTexture.hpp"
 
 using namespace std;
 namespace Render3D
@@ -12,7 +14,10 @@ namespace Render3D
 	private:
 		int _width;
 		int _height;
-		unsigned char* _image;
+		shared_ptr<const TextureImage> _source; // image partagée du cache de textures
+		const unsigned char* _image;
+		TextureFormat _format;
+		VirtualTextureView _virtual; // très grande texture : tuiles chargées à la demande
 		std::atomic<bool> _isLoaded;
 		vec2 UV1;
 		vec2 UV2;
@@ -28,16 +33,16 @@ namespace Render3D
 
 	public:
 		TextureNormalMap();
-		TextureNormalMap(string pathTexture);
+		TextureNormalMap(string pathTexture, float pixelsPerUv = FullResolution);
 		~TextureNormalMap();
-		void loadTexture();
+		void loadTexture(float pixelsPerUv = FullResolution);
 		void setPixel(float u, float v);
-		vec3 GetPixelNormal(Face& f, vec3 a, vec3 b, vec3 c,  vector<vec2>& uvs, vec3 weight, mat3x3 w, bool parallax = false);
-		mat3x3 getTBN(Face& f, vec3 a, vec3 b, vec3 c,  vector<vec2>& uvs, vec3 weight, mat3x3 w);
+		vec3 GetPixelNormal(const Face& f, vec3 a, vec3 b, vec3 c,  const vector<vec2>& uvs, vec3 weight, mat3x3 w, bool parallax = false);
+		mat3x3 getTBN(const Face& f, vec3 a, vec3 b, vec3 c,  const vector<vec2>& uvs, vec3 weight, mat3x3 w);
 		bool getLoaded();
-		mat3x3 preCompute(Face& f, vec3 a, vec3 b, vec3 c,  vector<vec2>& uvs, vec3 normal, mat3x3 w);
-		void computeTangent(Face& f, float coef);
-		void computeBiTangent(Face& f, float coef);
+		mat3x3 preCompute(const Face& f, vec3 a, vec3 b, vec3 c,  const vector<vec2>& uvs, vec3 normal, mat3x3 w);
+		vec3 computeTangent(float coef) const;
+		vec3 computeBiTangent(float coef) const;
 		vec3 getNormal() const;
 
 	};
@@ -1,11 +1,33 @@
-#include "../Tools/jpeg.hpp"
 #include "TextureParallaxMapping.h"
+#include <algorithm>
 #include <iostream>
 #include <atomic>
 #include <mutex>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 using namespace Render3D;
 
+namespace
+{
+	// Couches du lancer de rayon : de face, et en vue rasante.
+	constexpr int MinParallaxLayers = 4;
+	constexpr int MaxParallaxLayers = 32;
+	constexpr int MaxRefinementSteps = 6;
+
+	bool ParallaxOcclusionEnabled()
+	{
+		const char* env = std::getenv("R3D_PARALLAX");
+		return env == nullptr || (strcmp(env, "offset") != 0 && strcmp(env, "0") != 0);
+	}
+
+	float Luminance(const unsigned char rgb[3])
+	{
+		return (rgb[0] * 0.30f + rgb[1] * 0.59f + rgb[2] * 0.11f) / 255.0f;
+	}
+}
+
 TextureParallaxMapping::TextureParallaxMapping() {
 	_pathTextureDisp = "";
 	_height_scale = 0;
@@ -14,9 +36,10 @@ TextureParallaxMapping::TextureParallaxMapping() {
 	_isLoaded.store(false);
 	_image = nullptr;
 	_pHeigth = {};
+	_occlusion = ParallaxOcclusionEnabled();
 }
 
-TextureParallaxMapping::TextureParallaxMapping(string pathTextureDisp, float height_scale) {
+TextureParallaxMapping::TextureParallaxMapping(string pathTextureDisp, float height_scale, float pixelsPerUv) {
 	_pathTextureDisp = pathTextureDisp;
 	_height_scale = height_scale;
 	_width = 0;
@@ -24,26 +47,48 @@ TextureParallaxMapping::TextureParallaxMapping(string pathTextureDisp, float hei
 	_isLoaded.store(false);
 	_image = nullptr;
 	_pHeigth = {};
+	_occlusion = ParallaxOcclusionEnabled();
 	if (pathTextureDisp.empty() == false)
 	{
-		loadTexture();
+		loadTexture(pixelsPerUv);
 	}
 }
 
 Render3D::TextureParallaxMapping::~TextureParallaxMapping()
 {
-	delete[] _image;
 }
 
-void TextureParallaxMapping::loadTexture()
+void TextureParallaxMapping::loadTexture(float pixelsPerUv)
 {
-	_isLoaded.store(readJPEG(_pathTextureDisp.c_str(), _image, _width, _height));
+	if (UseVirtualTexture(_pathTextureDisp))
+	{
+		_isLoaded.store(_virtual.open(_pathTextureDisp, pixelsPerUv));
+		_width = _virtual.width();
+		_height = _virtual.height();
+		return;
+	}
+	TextureCache& cache = GetTextureCache();
+	_source = cache.get(_pathTextureDisp, cache.selectLevel(_pathTextureDisp, pixelsPerUv));
+	_image = _source->pixels;
+	_width = _source->width;
+	_height = _source->height;
+	_isLoaded.store(_source->loaded);
 }
 
 void TextureParallaxMapping::setPixel(float u, float v) {
 	int x = static_cast<int>(u * (_width-1));
 	int y = static_cast<int>(v * (_height-1));
 	int index = 3 * (y * _height + x);
+	if (_virtual.is_open())
+	{
+		unsigned char rgb[3];
+		index = std::clamp(index / 3, 0, _width * _height - 1);
+		_virtual.fetch(index % _width, index / _width, rgb);
+		_pHeigth.x = rgb[0];
+		_pHeigth.y = rgb[1];
+		_pHeigth.z = rgb[2];
+		return;
+	}
 	_pHeigth.x = _image[index];
 	_pHeigth.y = _image[index+1];
 	_pHeigth.z = _image[index+2];
@@ -53,8 +98,97 @@ bool TextureParallaxMapping::getLoaded() const {
 	return _isLoaded.load();
 }
 
-vec2 TextureParallaxMapping::getParallaxMapping(vec2 texCoords, vec3 viewDir) const
+float TextureParallaxMapping::getDepth(vec2 texCoords)
 {
+	const int x = std::clamp(static_cast<int>(texCoords.x * (_width - 1)), 0, _width - 1);
+	const int y = std::clamp(static_cast<int>(texCoords.y * (_height - 1)), 0, _height - 1);
+	unsigned char rgb[3];
+	if (_virtual.is_open())
+	{
+		_virtual.fetch(x, y, rgb);
+	}
+	else
+	{
+		const unsigned char* p = _image + 3 * (static_cast<size_t>(y) * _width + x);
+		rgb[0] = p[0];
+		rgb[1] = p[1];
+		rgb[2] = p[2];
+	}
+	return Luminance(rgb);
+}
+
+vec2 TextureParallaxMapping::getParallaxOcclusionMapping(vec2 texCoords, vec3 viewDir)
+{
+	const float depth0 = (_pHeigth.x * 0.30f + _pHeigth.y * 0.59f + _pHeigth.z * 0.11f) / 255.0f;
+	// Décalage de texture pour toute la profondeur de la carte ; le rayon est borné en vue rasante.
+	const float cosTheta = std::clamp(std::abs(viewDir.z), 0.0f, 1.0f);
+	const vec2 shift = vec2(viewDir.x, viewDir.y) / std::max(cosTheta, 0.05f) * _height_scale;
+	const float texelsCrossed = std::sqrt(shift.x * shift.x * _width * _width + shift.y * shift.y * _height * _height);
+
+	// De face, ou à la surface même : le rayon reste dans le texel lu, un seul décalage suffit.
+	if (depth0 <= 0.0f || texelsCrossed * depth0 < 1.0f)
+	{
+		return texCoords - shift * depth0;
+	}
+
+	// Couches : plus nombreuses en vue rasante, jamais plus que de texels traversés.
+	int layers = static_cast<int>(std::lround(MinParallaxLayers + (MaxParallaxLayers - MinParallaxLayers) * (1.0f - cosTheta)));
+	layers = std::clamp(std::min(layers, static_cast<int>(std::ceil(texelsCrossed))), 1, MaxParallaxLayers);
+
+	const float layerDepth = 1.0f / layers;
+	const vec2 deltaUv = shift * layerDepth;
+	float previousLayer = 0.0f;
+	float previousDepth = depth0;
+	float currentLayer = layerDepth;
+	vec2 current = texCoords - deltaUv;
+	float currentDepth = getDepth(current);
+	while (currentLayer < currentDepth)
+	{
+		previousLayer = currentLayer;
+		previousDepth = currentDepth;
+		currentLayer += layerDepth;
+		current -= deltaUv;
+		currentDepth = getDepth(current);
+	}
+
+	// Dichotomie entre la dernière couche au-dessus du relief et la première en dessous,
+	// tant que l'intervalle couvre plus d'un texel.
+	float above = previousLayer;
+	float below = currentLayer;
+	float span = texelsCrossed * layerDepth;
+	for (int step = 0; step < MaxRefinementSteps && span > 1.0f; step++)
+	{
+		const float middle = 0.5f * (above + below);
+		const float depth = getDepth(texCoords - shift * middle);
+		if (middle < depth)
+		{
+			above = middle;
+			previousDepth = depth;
+		}
+		else
+		{
+			below = middle;
+			currentDepth = depth;
+		}
+		span *= 0.5f;
+	}
+
+	// Intersection des deux derniers segments (relief et rayon), comme en relief mapping.
+	const float afterDepth = currentDepth - below;
+	const float beforeDepth = previousDepth - above;
+	const float denominator = afterDepth - beforeDepth;
+	const float weight = std::abs(denominator) > 1e-6f ? afterDepth / denominator : 0.0f;
+	const float hit = below + (above - below) * std::clamp(weight, 0.0f, 1.0f);
+	return texCoords - shift * hit;
+}
+
+vec2 TextureParallaxMapping::getParallaxMapping(vec2 texCoords, vec3 viewDir)
+{
+	if (_occlusion && _width > 0 && _height > 0)
+	{
+		return getParallaxOcclusionMapping(texCoords, viewDir);
+	}
+
 	float height = (_pHeigth.x * 0.30f + _pHeigth.y * 0.59f + _pHeigth.z * 0.11f) / 255.0f;
 	vec2 p = {};
 	p.x = (viewDir.x / viewDir.z) * (height * _height_scale);
@@ -11,18 +11,35 @@ namespace Render3D
 		int _width;
 		int _height;
 		std::atomic<bool> _isLoaded;
-		unsigned char* _image;
+		shared_ptr<const TextureImage> _source; // image partagée du cache de textures
+		const unsigned char* _image;
+		VirtualTextureView _virtual; // très grande texture : tuiles chargées à la demande
 		vec3 _pHeigth;
+		bool _occlusion; // parallax occlusion mapping (lancer de rayon) plutôt qu'un seul décalage
 		std::mutex _loadMutex;
 
+		float getDepth(vec2 texCoords);
+		vec2 getParallaxOcclusionMapping(vec2 texCoords, vec3 viewDir);
+
 	public:
 		TextureParallaxMapping();
 		TextureParallaxMapping(const TextureParallaxMapping& other) = delete;
-		TextureParallaxMapping(string pathTextureDisp, float height_scale);
+		TextureParallaxMapping(string pathTextureDisp, float height_scale, float pixelsPerUv = FullResolution);
 		~TextureParallaxMapping();
-		void loadTexture();
+		void loadTexture(float pixelsPerUv = FullResolution);
 		void setPixel(float u, float v);
 		bool getLoaded() const;
-		vec2 getParallaxMapping(vec2 texCoords, vec3 viewDir) const;
+
+		/**
+		 * @brief Coordonnées de texture décalées par le relief, vu depuis viewDir
+		 * @param texCoords Coordonnées du pixel, dont la hauteur a été lue par setPixel
+		 * @param viewDir Direction de la caméra dans l'espace tangent, normalisée
+		 *
+		 * Par défaut, le rayon de vue est avancé par couches dans la carte de hauteur jusqu'à la première
+		 * intersection, puis affiné par dichotomie ; le nombre de couches croît avec l'inclinaison du regard
+		 * et se limite aux texels traversés au niveau de résolution chargé. R3D_PARALLAX=offset garde
+		 * le simple décalage d'une seule lecture de hauteur.
+		 */
+		vec2 getParallaxMapping(vec2 texCoords, vec3 viewDir);
 	};
 }
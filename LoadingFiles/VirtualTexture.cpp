@@ -0,0 +1,477 @@
+/**
+ * @file VirtualTexture.cpp
+ * @brief Construction des fichiers de tuiles .r3dv, table des pages et résidence des tuiles.
+ */
+
+#include "VirtualTexture.hpp"
+#include "DecodedTextureCache.hpp"
+#include "TextureCache.hpp"
+#include "../Tools/jpeg.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace Render3D;
+
+namespace
+{
+    constexpr char VirtualMagic[4] = { 'R', '3', 'D', 'V' };
+    constexpr uint32_t VirtualVersion = 1;
+    constexpr size_t VirtualAlignment = 4096; // tuiles alignées sur les pages : rendues au système une fois copiées
+    constexpr size_t TileBytes = static_cast<size_t>(VirtualTileSize) * VirtualTileSize * 3;
+    constexpr int VirtualThreshold = 8192;
+    constexpr size_t DefaultVirtualBudgetMB = 512;
+    constexpr uint32_t MaxLevels = 32;
+
+    struct VirtualHeader
+    {
+        char magic[4];
+        uint32_t version;
+        SourceStamp source;
+        uint64_t tiles;      // offset de la première tuile (aligné sur VirtualAlignment)
+        uint32_t levelCount; // VirtualLevel[levelCount] à la suite de l'en-tête
+        uint32_t keyLength;  // chemin canonique du JPEG, à la suite des niveaux
+    };
+
+    string TilesSuffix()
+    {
+        return ".r3dv";
+    }
+
+    // Niveaux de la chaîne de mipmaps : chaque niveau divise la taille par deux (arrondi au-dessus)
+    // jusqu'à tenir dans une seule tuile.
+    vector<VirtualLevel> MakeLevels(uint32_t width, uint32_t height)
+    {
+        vector<VirtualLevel> levels;
+        uint32_t firstTile = 0;
+        for (;;)
+        {
+            VirtualLevel level{};
+            level.width = width;
+            level.height = height;
+            level.tilesX = (width + VirtualTileSize - 1) / VirtualTileSize;
+            level.tilesY = (height + VirtualTileSize - 1) / VirtualTileSize;
+            level.firstTile = firstTile;
+            levels.push_back(level);
+            firstTile += level.tilesX * level.tilesY;
+            if (level.tilesX == 1 && level.tilesY == 1)
+                return levels;
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+
+    // Écrit les tuiles de tous les niveaux à partir des lignes du niveau 0, de haut en bas :
+    // chaque niveau garde une bande de VirtualTileSize lignes et la ligne en attente de sa paire
+    // pour le niveau suivant. Une texture de 16K n'occupe ainsi que quelques dizaines de Mo.
+    class TileWriter
+    {
+        private:
+            struct LevelState
+            {
+                vector<unsigned char> band;
+                vector<unsigned char> pending;
+                vector<unsigned char> down;
+                int bandRows = 0;
+                uint32_t bandIndex = 0;
+                uint32_t rows = 0;
+                bool hasPending = false;
+            };
+
+            ofstream& _out;
+            uint64_t _tiles;
+            const vector<VirtualLevel>& _levels;
+            vector<LevelState> _state;
+            vector<unsigned char> _tile;
+
+            void flush(size_t level)
+            {
+                const VirtualLevel& l = _levels[level];
+                LevelState& s = _state[level];
+                const size_t stride = static_cast<size_t>(l.width) * 3;
+                for (uint32_t tx = 0; tx < l.tilesX; tx++)
+                {
+                    const size_t columns = min<size_t>(VirtualTileSize, l.width - tx * VirtualTileSize) * 3;
+                    fill(_tile.begin(), _tile.end(), static_cast<unsigned char>(0));
+                    for (int r = 0; r < s.bandRows; r++)
+                        memcpy(&_tile[static_cast<size_t>(r) * VirtualTileSize * 3], &s.band[r * stride + tx * VirtualTileSize * 3], columns);
+                    const uint64_t index = l.firstTile + static_cast<uint64_t>(s.bandIndex) * l.tilesX + tx;
+                    _out.seekp(static_cast<streamoff>(_tiles + index * TileBytes));
+                    _out.write(reinterpret_cast<const char*>(_tile.data()), static_cast<streamsize>(TileBytes));
+                }
+                s.bandRows = 0;
+                s.bandIndex++;
+            }
+
+            // Moyenne 2x2 de deux lignes (la dernière colonne d'une largeur impaire est dupliquée).
+            void downsample(size_t level, const unsigned char* a, const unsigned char* b)
+            {
+                const uint32_t width = _levels[level].width;
+                LevelState& s = _state[level];
+                for (uint32_t x = 0; x < _levels[level + 1].width; x++)
+                {
+                    const uint32_t x0 = 2 * x, x1 = min(2 * x + 1, width - 1);
+                    for (int c = 0; c < 3; c++)
+                        s.down[x * 3 + c] = static_cast<unsigned char>((a[x0 * 3 + c] + a[x1 * 3 + c] + b[x0 * 3 + c] + b[x1 * 3 + c] + 2) / 4);
+                }
+            }
+
+        public:
+            TileWriter(ofstream& out, uint64_t tiles, const vector<VirtualLevel>& levels)
+                : _out(out), _tiles(tiles), _levels(levels), _state(levels.size()), _tile(TileBytes)
+            {
+                for (size_t k = 0; k < levels.size(); k++)
+                {
+                    const size_t stride = static_cast<size_t>(levels[k].width) * 3;
+                    _state[k].band.resize(stride * VirtualTileSize);
+                    _state[k].pending.resize(stride);
+                    if (k + 1 < levels.size())
+                        _state[k].down.resize(static_cast<size_t>(levels[k + 1].width) * 3);
+                }
+            }
+
+            void pushRow(size_t level, const unsigned char* row)
+            {
+                const VirtualLevel& l = _levels[level];
+                LevelState& s = _state[level];
+                const size_t stride = static_cast<size_t>(l.width) * 3;
+                memcpy(&s.band[s.bandRows * stride], row, stride);
+                s.bandRows++;
+                s.rows++;
+                const bool last = s.rows == l.height;
+                if (s.bandRows == VirtualTileSize || last)
+                    flush(level);
+
+                if (level + 1 == _levels.size())
+                    return;
+                if (s.hasPending)
+                {
+                    downsample(level, s.pending.data(), row);
+                    s.hasPending = false;
+                    pushRow(level + 1, s.down.data());
+                }
+                else if (last)
+                {
+                    downsample(level, row, row); // hauteur impaire : la dernière ligne est dupliquée
+                    pushRow(level + 1, s.down.data());
+                }
+                else
+                {
+                    memcpy(s.pending.data(), row, stride);
+                    s.hasPending = true;
+                }
+            }
+    };
+
+    bool BuildTiles(const string& path, const string& key, const string& entryPath)
+    {
+        // Relevé pris avant le décodage : un JPEG modifié pendant celui-ci invalide le fichier écrit.
+        const SourceStamp source = StampFile(path, true);
+        JpegRowReader reader(path.c_str());
+        if (!reader.is_open() || reader.width() <= 0 || reader.height() <= 0)
+            return false;
+
+        const vector<VirtualLevel> levels = MakeLevels(static_cast<uint32_t>(reader.width()), static_cast<uint32_t>(reader.height()));
+        VirtualHeader header{};
+        memcpy(header.magic, VirtualMagic, sizeof(VirtualMagic));
+        header.version = VirtualVersion;
+        header.source = source;
+        header.levelCount = static_cast<uint32_t>(levels.size());
+        header.keyLength = static_cast<uint32_t>(key.size());
+        const size_t prefix = sizeof(VirtualHeader) + levels.size() * sizeof(VirtualLevel) + key.size();
+        header.tiles = (prefix + VirtualAlignment - 1) / VirtualAlignment * VirtualAlignment;
+
+        error_code ec;
+        filesystem::create_directories(filesystem::path(entryPath).parent_path(), ec);
+        const string tmpPath = entryPath + "." + to_string(random_device{}()) + ".tmp";
+        {
+            ofstream out(tmpPath, ios::binary | ios::trunc);
+            if (!out)
+            {
+                cerr << "Virtual texture not built: cannot write " << tmpPath << endl;
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(levels.data()), static_cast<streamsize>(levels.size() * sizeof(VirtualLevel)));
+            out.write(key.data(), static_cast<streamsize>(key.size()));
+
+            TileWriter writer(out, header.tiles, levels);
+            const size_t stride = static_cast<size_t>(reader.width()) * 3;
+            vector<unsigned char> rows(stride * 16);
+            int decoded = 0;
+            while (decoded < reader.height())
+            {
+                const int count = reader.readRows(rows.data(), min(16, reader.height() - decoded));
+                if (count <= 0)
+                    break;
+                for (int r = 0; r < count; r++)
+                    writer.pushRow(0, &rows[r * stride]);
+                decoded += count;
+            }
+            out.close();
+            if (decoded != reader.height() || !out)
+            {
+                cerr << "Virtual texture not built: cannot write " << tmpPath << endl;
+                filesystem::remove(tmpPath, ec);
+                return false;
+            }
+        }
+
+        filesystem::rename(tmpPath, entryPath, ec);
+        if (ec)
+        {
+            cerr << "Virtual texture not built: " << ec.message() << endl;
+            filesystem::remove(tmpPath, ec);
+            return false;
+        }
+        return true;
+    }
+}
+
+bool Render3D::UseVirtualTexture(const string& path)
+{
+    if (path.empty() || DecodedTextureCacheDirectory().empty())
+        return false;
+    const char* env = std::getenv("R3D_VIRTUAL_TEXTURE");
+    if (env != nullptr)
+        return strcmp(env, "0") != 0;
+    int width, height;
+    return GetTextureCache().imageSize(path, width, height) && max(width, height) > VirtualThreshold;
+}
+
+size_t Render3D::VirtualTextureBudgetBytes()
+{
+    const char* env = std::getenv("R3D_VIRTUAL_TEXTURE_BUDGET_MB");
+    const long megabytes = env != nullptr ? strtol(env, nullptr, 10) : 0;
+    return (megabytes > 0 ? static_cast<size_t>(megabytes) : DefaultVirtualBudgetMB) << 20;
+}
+
+bool VirtualTexture::open(const string& path)
+{
+    const string directory = DecodedTextureCacheDirectory();
+    if (directory.empty())
+        return false;
+    const string key = TextureSourceKey(path);
+    const string entryPath = TextureEntryPath(directory, key, TilesSuffix());
+
+    // Deux essais : le fichier existant, puis celui qui vient d'être construit.
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (attempt == 1 && !BuildTiles(path, key, entryPath))
+            return false;
+        if (!_file.open(entryPath) || _file.size() < sizeof(VirtualHeader))
+            continue;
+
+        VirtualHeader header;
+        memcpy(&header, _file.data(), sizeof(VirtualHeader));
+        const uint64_t size = _file.size();
+        if (memcmp(header.magic, VirtualMagic, sizeof(VirtualMagic)) != 0 || header.version != VirtualVersion ||
+            header.levelCount == 0 || header.levelCount > MaxLevels ||
+            size < sizeof(VirtualHeader) + header.levelCount * sizeof(VirtualLevel) ||
+            header.keyLength > size - sizeof(VirtualHeader) - header.levelCount * sizeof(VirtualLevel))
+            continue;
+
+        _levels.resize(header.levelCount);
+        memcpy(_levels.data(), _file.data() + sizeof(VirtualHeader), _levels.size() * sizeof(VirtualLevel));
+        const char* storedKey = _file.data() + sizeof(VirtualHeader) + _levels.size() * sizeof(VirtualLevel);
+        const vector<VirtualLevel> expected = MakeLevels(_levels[0].width, _levels[0].height);
+        const uint64_t tileCount = static_cast<uint64_t>(expected.back().firstTile) + expected.back().tilesX * expected.back().tilesY;
+        if (key.compare(0, string::npos, storedKey, header.keyLength) != 0 || _levels[0].width == 0 || _levels[0].height == 0 ||
+            expected.size() != _levels.size() || memcmp(expected.data(), _levels.data(), _levels.size() * sizeof(VirtualLevel)) != 0 ||
+            header.tiles % VirtualAlignment != 0 || header.tiles > size || tileCount > (size - header.tiles) / TileBytes)
+            continue;
+
+        // JPEG modifié depuis la construction : le fichier est reconstruit.
+        if (!SameSource(header.source, path))
+            continue;
+
+        _tiles = header.tiles;
+        _pages = vector<Page>(tileCount);
+        return true;
+    }
+    return false;
+}
+
+int VirtualTexture::get_levelCount() const
+{
+    return static_cast<int>(_levels.size());
+}
+
+const VirtualLevel& VirtualTexture::get_level(int level) const
+{
+    return _levels[level];
+}
+
+int VirtualTexture::selectLevel(float pixelsPerUv) const
+{
+    if (pixelsPerUv >= FullResolution)
+        return 0;
+    // Texels par unité de uv à un niveau : la taille de l'image à ce niveau.
+    int level = 0;
+    while (level + 1 < get_levelCount() && static_cast<float>(min(_levels[level + 1].width, _levels[level + 1].height)) >= pixelsPerUv)
+        level++;
+    return level;
+}
+
+shared_ptr<const VirtualTile> VirtualTexture::readTile(uint32_t index)
+{
+    shared_ptr<VirtualTile> tile = make_shared<VirtualTile>();
+    tile->texels.reset(new unsigned char[TileBytes]);
+    const uint64_t offset = _tiles + static_cast<uint64_t>(index) * TileBytes;
+    memcpy(tile->texels.get(), _file.data() + offset, TileBytes);
+    // La tuile est recopiée : ses pages dans la projection peuvent être rendues.
+    _file.discard(offset, TileBytes);
+    return tile;
+}
+
+VirtualTexturePool::VirtualTexturePool(size_t budgetBytes) : _budget(budgetBytes)
+{
+}
+
+shared_ptr<VirtualTexture> VirtualTexturePool::open(const string& path)
+{
+    Entry* entry;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        unique_ptr<Entry>& slot = _entries[path];
+        if (!slot)
+            slot = make_unique<Entry>();
+        entry = slot.get();
+    }
+    // Construction du fichier de tuiles une seule fois ; les autres threads attendent sa fin.
+    call_once(entry->opened, [&] {
+        shared_ptr<VirtualTexture> texture = make_shared<VirtualTexture>();
+        if (!texture->open(path))
+        {
+            cerr << "Virtual texture unavailable: " << path << endl;
+            return;
+        }
+        // Le dernier niveau (une tuile) reste résident : repli de toutes les tuiles pas encore lues.
+        const VirtualLevel& last = texture->_levels.back();
+        shared_ptr<const VirtualTile> tile = texture->readTile(last.firstTile);
+        std::lock_guard<std::mutex> lock(_mutex);
+        VirtualTexture::Page& page = texture->_pages[last.firstTile];
+        page.tile = tile;
+        page.pinned = true;
+        _residentBytes += TileBytes;
+        _loadCount++;
+        entry->texture = texture;
+    });
+    return entry->texture;
+}
+
+shared_ptr<const VirtualTile> VirtualTexturePool::acquire(VirtualTexture& texture, uint32_t index)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        VirtualTexture::Page& page = texture._pages[index];
+        if (page.tile)
+        {
+            if (!page.pinned)
+                _lru.splice(_lru.begin(), _lru, page.lru);
+            return page.tile;
+        }
+        if (page.loading)
+            return nullptr;
+        page.loading = true;
+    }
+
+    shared_ptr<const VirtualTile> tile = texture.readTile(index);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    VirtualTexture::Page& page = texture._pages[index];
+    page.loading = false;
+    page.tile = tile;
+    _lru.emplace_front(&texture, index);
+    page.lru = _lru.begin();
+    _residentBytes += TileBytes;
+    _loadCount++;
+
+    // Au-delà du budget, les tuiles les moins récemment utilisées sont libérées (jamais celle qui vient d'être lue).
+    while (_residentBytes > _budget && _lru.size() > 1)
+    {
+        VirtualTexture::Page& oldest = _lru.back().first->_pages[_lru.back().second];
+        oldest.tile.reset();
+        _lru.pop_back();
+        _residentBytes -= TileBytes;
+    }
+    return tile;
+}
+
+size_t VirtualTexturePool::get_residentBytes()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _residentBytes;
+}
+
+size_t VirtualTexturePool::get_loadCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _loadCount;
+}
+
+VirtualTexturePool& Render3D::GetVirtualTexturePool()
+{
+    static VirtualTexturePool pool(VirtualTextureBudgetBytes());
+    return pool;
+}
+
+bool VirtualTextureView::open(const string& path, float pixelsPerUv)
+{
+    _texture = GetVirtualTexturePool().open(path);
+    _tile.reset();
+    if (!_texture)
+        return false;
+    _level = _texture->selectLevel(pixelsPerUv);
+    return true;
+}
+
+int VirtualTextureView::width() const
+{
+    return _texture ? static_cast<int>(_texture->get_level(_level).width) : 0;
+}
+
+int VirtualTextureView::height() const
+{
+    return _texture ? static_cast<int>(_texture->get_level(_level).height) : 0;
+}
+
+void VirtualTextureView::fetch(int x, int y, unsigned char rgb[3])
+{
+    const VirtualLevel& base = _texture->get_level(_level);
+    // Les tuiles suivent l'ordre des lignes du JPEG (de haut en bas).
+    int column = std::clamp(x, 0, static_cast<int>(base.width) - 1);
+    int row = static_cast<int>(base.height) - 1 - std::clamp(y, 0, static_cast<int>(base.height) - 1);
+
+    for (int level = _level;; level++)
+    {
+        const VirtualLevel& l = _texture->get_level(level);
+        const uint32_t index = l.firstTile + static_cast<uint32_t>(row / VirtualTileSize) * l.tilesX + static_cast<uint32_t>(column / VirtualTileSize);
+        const size_t texel = (static_cast<size_t>(row % VirtualTileSize) * VirtualTileSize + column % VirtualTileSize) * 3;
+        // Cas courant : même tuile que le texel précédent, sans passer par le pool.
+        if (level == _level && _tile && _tileIndex == index)
+        {
+            memcpy(rgb, _tile->texels.get() + texel, 3);
+            return;
+        }
+        shared_ptr<const VirtualTile> tile = GetVirtualTexturePool().acquire(*_texture, index);
+        if (tile)
+        {
+            memcpy(rgb, tile->texels.get() + texel, 3);
+            if (level == _level)
+            {
+                _tile = std::move(tile);
+                _tileIndex = index;
+            }
+            return;
+        }
+        // Tuile en cours de lecture par un autre thread : texel correspondant du niveau plus grossier.
+        column /= 2;
+        row /= 2;
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * @file VirtualTexture.hpp
+ * @brief Textures virtuelles : très grandes textures découpées en tuiles de 128x128 texels, chargées à la demande.
+ *
+ * Au premier usage, le JPEG est décodé une seule fois, ligne par ligne, vers un fichier .r3dv du dossier
+ * de cache des textures (DecodedTextureCache.hpp) : pour chaque niveau de la chaîne de mipmaps (moyennes 2x2
+ * jusqu'à une seule tuile), les tuiles RGB brutes à des positions fixes. Au rendu, une tuile est lue depuis
+ * ce fichier la première fois qu'un texel en est échantillonné ; les tuiles résidentes de toutes les textures
+ * partagent un budget mémoire, et les moins récemment utilisées sont libérées quand il est dépassé.
+ * Une tuile en cours de lecture par un autre thread est remplacée par le niveau plus grossier le plus fin
+ * déjà résident ; le dernier niveau (une tuile) reste toujours en mémoire.
+ */
+
+#ifndef VirtualTexture_hpp
+#define VirtualTexture_hpp
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MeshCache.hpp"
+#include "../Tools/MappedFile.hpp"
+
+using namespace std;
+
+namespace Render3D
+{
+    /// Côté d'une tuile, en texels.
+    constexpr int VirtualTileSize = 128;
+
+    /**
+     * @brief Indique si une texture doit être échantillonnée par tuiles plutôt que décodée en entier
+     * @param path Chemin du fichier JPEG
+     *
+     * La variable d'environnement R3D_VIRTUAL_TEXTURE=1 force les tuiles, R3D_VIRTUAL_TEXTURE=0 les interdit ;
+     * sinon elles sont choisies pour les textures de plus de 8192 texels de côté. Sans dossier de cache
+     * (R3D_TEXTURE_CACHE=0), les textures sont toujours décodées en entier.
+     */
+    bool UseVirtualTexture(const string& path);
+
+    /**
+     * @brief Budget mémoire des tuiles résidentes de toutes les textures virtuelles, en octets
+     *
+     * Lu dans R3D_VIRTUAL_TEXTURE_BUDGET_MB (512 Mo par défaut).
+     */
+    size_t VirtualTextureBudgetBytes();
+
+    /**
+     * @struct VirtualLevel
+     * @brief Niveau de la chaîne de mipmaps d'une texture virtuelle
+     */
+    struct VirtualLevel
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t tilesX;
+        uint32_t tilesY;
+        uint32_t firstTile; // indice de la première tuile du niveau dans le fichier
+        uint32_t padding;
+    };
+
+    /**
+     * @struct VirtualTile
+     * @brief Tuile résidente : VirtualTileSize lignes de VirtualTileSize texels RGB, de haut en bas comme le JPEG
+     */
+    struct VirtualTile
+    {
+        unique_ptr<unsigned char[]> texels;
+    };
+
+    class VirtualTexturePool;
+
+    /**
+     * @class VirtualTexture
+     * @brief Fichier .r3dv projeté en mémoire et table des pages de ses tuiles
+     */
+    class VirtualTexture
+    {
+        friend class VirtualTexturePool;
+
+        private:
+            // Page d'une tuile : résidente, en cours de lecture, ou seulement sur disque. Protégée par le mutex du pool.
+            struct Page
+            {
+                shared_ptr<const VirtualTile> tile;
+                list<pair<VirtualTexture*, uint32_t>>::iterator lru;
+                bool loading = false;
+                bool pinned = false; // dernier niveau : jamais libéré
+            };
+
+            MappedFile _file;
+            vector<VirtualLevel> _levels;
+            uint64_t _tiles = 0; // offset de la première tuile
+            vector<Page> _pages;
+
+            shared_ptr<const VirtualTile> readTile(uint32_t index);
+
+        public:
+            /**
+             * @brief Ouvre le fichier de tuiles d'un JPEG, après l'avoir construit s'il manque ou n'est plus à jour
+             * @return false si le JPEG ne peut pas être lu ou le fichier écrit
+             */
+            bool open(const string& path);
+
+            int get_levelCount() const;
+            const VirtualLevel& get_level(int level) const;
+
+            /**
+             * @brief Niveau le plus grossier qui garde au moins un texel par pixel
+             * @param pixelsPerUv Pixels de l'écran par unité de coordonnée de texture (FullResolution : inconnue)
+             */
+            int selectLevel(float pixelsPerUv) const;
+    };
+
+    /**
+     * @class VirtualTexturePool
+     * @brief Textures virtuelles ouvertes et tuiles résidentes, sous un budget mémoire commun
+     */
+    class VirtualTexturePool
+    {
+        private:
+            struct Entry
+            {
+                once_flag opened;
+                shared_ptr<VirtualTexture> texture; // nul si le fichier de tuiles n'a pas pu être ouvert
+            };
+
+            std::mutex _mutex;
+            unordered_map<string, unique_ptr<Entry>> _entries;
+            list<pair<VirtualTexture*, uint32_t>> _lru; // tuiles non épinglées, de la plus récente à la plus ancienne
+            size_t _budget;
+            size_t _residentBytes = 0;
+            size_t _loadCount = 0;
+
+        public:
+            explicit VirtualTexturePool(size_t budgetBytes);
+
+            /**
+             * @brief Renvoie la texture virtuelle d'un JPEG, ouverte (ou construite) une seule fois par processus
+             * @return nullptr si elle n'a pas pu être ouverte
+             */
+            shared_ptr<VirtualTexture> open(const string& path);
+
+            /**
+             * @brief Renvoie une tuile, lue depuis le fichier si elle n'est pas résidente
+             * @param texture Texture virtuelle
+             * @param index Indice de la tuile dans le fichier
+             * @return nullptr si un autre thread est en train de la lire
+             *
+             * La tuile reste valide tant que le pointeur est gardé, même si elle est libérée entre-temps.
+             */
+            shared_ptr<const VirtualTile> acquire(VirtualTexture& texture, uint32_t index);
+
+            /// Mémoire occupée par les tuiles résidentes, en octets.
+            size_t get_residentBytes();
+
+            /// Nombre de tuiles lues depuis les fichiers depuis le démarrage.
+            size_t get_loadCount();
+    };
+
+    /// Pool de textures virtuelles du processus.
+    VirtualTexturePool& GetVirtualTexturePool();
+
+    /**
+     * @class VirtualTextureView
+     * @brief Échantillonnage d'une texture virtuelle à un niveau donné, avec la dernière tuile utilisée
+     *
+     * Une vue par texture et par lot de faces : elle n'est pas partagée entre threads.
+     */
+    class VirtualTextureView
+    {
+        private:
+            shared_ptr<VirtualTexture> _texture;
+            int _level = 0;
+            uint32_t _tileIndex = 0;
+            shared_ptr<const VirtualTile> _tile;
+
+        public:
+            /**
+             * @brief Ouvre la texture virtuelle d'un JPEG au niveau qui convient à une empreinte à l'écran
+             * @return false si elle n'a pas pu être ouverte
+             */
+            bool open(const string& path, float pixelsPerUv);
+
+            bool is_open() const { return _texture != nullptr; }
+            int width() const;
+            int height() const;
+
+            /**
+             * @brief Couleur du texel (x, y) du niveau ouvert, lignes comptées de bas en haut comme TextureImage
+             */
+            void fetch(int x, int y, unsigned char rgb[3]);
+    };
+};
+#endif /* VirtualTexture_hpp */
@@ -6,11 +6,11 @@ using namespace Render3D;
 
 AmbientOcclusion::AmbientOcclusion() {}
 
-void AmbientOcclusion::computeArea(vector<vec3>& vertices, vector<Face>& faces)
+void AmbientOcclusion::computeArea(const vector<vec3>& vertices, const vector<Face>& faces, vector<float>& area)
 {
-	map<int, float> occlusions;
+	area.assign(vertices.size(), 0.0f);
 
-	for (Face f : faces) {
+	for (const Face& f : faces) {
 		float normAB = (float)sqrt(	pow(vertices[f.B.IndiceVertices-1].x - vertices[f.A.IndiceVertices-1].x, 2.0) +
 								pow(vertices[f.B.IndiceVertices-1].y - vertices[f.A.IndiceVertices-1].y, 2.0) + 
 								pow(vertices[f.B.IndiceVertices-1].z - vertices[f.A.IndiceVertices-1].z, 2.0));
@@ -27,9 +27,9 @@ void AmbientOcclusion::computeArea(vector<vec3>& vertices, vector<Face>& faces)
 
 		float Area = sqrt(demiSphere * (demiSphere - normAB) * (demiSphere - normBC) * (demiSphere - normCA));
 
-		f.A.area += Area / 3.0f;
-		f.B.area += Area / 3.0f;
-		f.C.area += Area / 3.0f;
+		area[f.A.IndiceVertices - 1] += Area / 3.0f;
+		area[f.B.IndiceVertices - 1] += Area / 3.0f;
+		area[f.C.IndiceVertices - 1] += Area / 3.0f;
 	}
 }
 
@@ -62,7 +62,8 @@ float AmbientOcclusion::formFactor(Vertices emetrice, Vertices receptrice) {
 
 vector<vec3>  AmbientOcclusion::computeOcclusion(vector<vec3> vertices, vector<Face>& faces) {
 
-	computeArea(vertices, faces);
+	vector<float> area;
+	computeArea(vertices, faces, area);
 	int cursor = 0;
 	
 	for (int i = 0; i < vertices.size(); i++)
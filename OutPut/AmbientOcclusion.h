@@ -12,7 +12,7 @@ namespace Render3D
 		vector<vec3> computeOcclusion(vector<vec3> vertices, vector<Face>& faces);
 
 	private:
-		void computeArea(vector<vec3>& vertices, vector<Face>& faces);
+		void computeArea(const vector<vec3>& vertices, const vector<Face>& faces, vector<float>& area);
 		float formFactor(Vertices emetrice, Vertices receptrice);
 		float clamp(float occlusion);
 	};
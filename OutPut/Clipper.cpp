@@ -0,0 +1,91 @@
+/**
+ * @file Clipper.cpp
+ * @brief Découpage des triangles en coordonnées clip.
+ */
+
+#include "Clipper.hpp"
+#include <algorithm>
+
+using namespace Render3D;
+
+void Render3D::ComputeClipOutcodes(const float* x, const float* y, const float* z, const float* w, size_t count, unsigned char* out)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned char code = 0;
+        code |= (x[i] < -w[i]) ? OutcodeLeft : 0;
+        code |= (x[i] > w[i]) ? OutcodeRight : 0;
+        code |= (y[i] < -w[i]) ? OutcodeBottom : 0;
+        code |= (y[i] > w[i]) ? OutcodeTop : 0;
+        code |= (z[i] < -w[i]) ? OutcodeNear : 0;
+        code |= (z[i] > w[i]) ? OutcodeFar : 0;
+        out[i] = code;
+    }
+}
+
+// Distance signée d'un sommet au plan de découpage n° "plane" (positive = conservé).
+static float ClipDistance(const vec4& p, int plane)
+{
+    const float guard = GuardBand;
+
+    switch (plane)
+    {
+    case 0:
+        return p.z + p.w; // near
+    case 1:
+        return guard * p.w + p.x;
+    case 2:
+        return guard * p.w - p.x;
+    case 3:
+        return guard * p.w + p.y;
+    default:
+        return guard * p.w - p.y;
+    }
+}
+
+int Render3D::ClipTriangle(const vec4 clip[3], ClipVertex out[MaxClipVertices])
+{
+    ClipVertex bufferA[MaxClipVertices + 1];
+    ClipVertex bufferB[MaxClipVertices + 1];
+
+    ClipVertex* input = bufferA;
+    ClipVertex* output = bufferB;
+    int count = 3;
+
+    input[0] = {clip[0], vec3(1.0f, 0.0f, 0.0f)};
+    input[1] = {clip[1], vec3(0.0f, 1.0f, 0.0f)};
+    input[2] = {clip[2], vec3(0.0f, 0.0f, 1.0f)};
+
+    for (int plane = 0; plane < 5 && count > 0; plane++)
+    {
+        int outCount = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            const ClipVertex& current = input[i];
+            const ClipVertex& next = input[(i + 1) % count];
+            const float dCurrent = ClipDistance(current.position, plane);
+            const float dNext = ClipDistance(next.position, plane);
+
+            if (dCurrent >= 0.0f)
+                output[outCount++] = current;
+
+            // L'arête traverse le plan : on ajoute le point d'intersection.
+            if ((dCurrent >= 0.0f) != (dNext >= 0.0f))
+            {
+                const float t = dCurrent / (dCurrent - dNext);
+                output[outCount].position = current.position + (next.position - current.position) * t;
+                output[outCount].bary = current.bary + (next.bary - current.bary) * t;
+                outCount++;
+            }
+        }
+
+        std::swap(input, output);
+        count = outCount;
+    }
+
+    for (int i = 0; i < count; i++)
+        out[i] = input[i];
+
+    return count;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file Clipper.hpp
+ * @brief Codes de sortie et découpage des triangles en coordonnées clip (plan near et bande de garde).
+ */
+
+#ifndef Clipper_hpp
+#define Clipper_hpp
+
+#include <cstddef>
+#include "../Tools/MatrixTools.h"
+
+using namespace glm;
+
+namespace Render3D
+{
+    /**
+     * @brief Bits des codes de sortie : un par plan du frustum en coordonnées clip
+     */
+    enum ClipOutcode : unsigned char
+    {
+        OutcodeLeft = 0x01,   // x < -w
+        OutcodeRight = 0x02,  // x > w
+        OutcodeBottom = 0x04, // y < -w
+        OutcodeTop = 0x08,    // y > w
+        OutcodeNear = 0x10,   // z < -w
+        OutcodeFar = 0x20     // z > w
+    };
+
+    /**
+     * @brief Demi-largeur de la bande de garde, en unités NDC
+     *
+     * Un triangle qui déborde de l'écran mais reste dans [-GuardBand, GuardBand]
+     * est rasterisé tel quel (sa boîte est simplement bornée à l'écran) ; au-delà,
+     * les fonctions d'arête perdent en précision et il est découpé.
+     */
+    constexpr float GuardBand = 4.0f;
+
+    /**
+     * @struct ClipVertex
+     * @brief Sommet d'un polygone découpé : position clip et coordonnées barycentriques
+     *        dans le triangle d'origine (exactes, le découpage étant linéaire en espace clip)
+     */
+    struct ClipVertex
+    {
+        vec4 position;
+        vec3 bary;
+    };
+
+    /**
+     * @brief Un triangle découpé par le plan near et les 4 plans de la bande de garde
+     *        a au plus 3 + 5 sommets
+     */
+    constexpr int MaxClipVertices = 8;
+
+    /**
+     * @brief Calcule les codes de sortie des vertices en coordonnées clip
+     * @param x,y,z,w Coordonnées clip (SoA)
+     * @param count Nombre de vertices
+     * @param out Codes de sortie (combinaison de ClipOutcode)
+     */
+    void ComputeClipOutcodes(const float* x, const float* y, const float* z, const float* w, size_t count, unsigned char* out);
+
+    /**
+     * @brief Découpe un triangle (Sutherland–Hodgman) contre le plan near et la bande de garde
+     * @param clip Positions clip des 3 sommets
+     * @param out Polygone convexe résultant
+     * @return Nombre de sommets du polygone (0 si le triangle est entièrement rejeté)
+     */
+    int ClipTriangle(const vec4 clip[3], ClipVertex out[MaxClipVertices]);
+}
+
+#endif /* Clipper_hpp */
@@ -10,7 +10,9 @@
  */
 
 #include "Device.hpp"
+#include "Clipper.hpp"
 #include <iostream>
+#include <limits>
 #include "../OutPut/AmbientOcclusion.h"
 #include <thread>
 #include <mutex>
@@ -128,60 +130,97 @@ float ComputeEdgeFunction(vec3 &a, vec3 &b, vec3 &c)
 }
 
 /**
- * @brief Remplit un triangle à l'écran avec gestion du Z-buffer, textures, normales, etc.
- * @param proj Matrice de projection
- * @param world Matrice de transformation monde
- * @param f Face à rasteriser
- * @param mesh Maillage
- * @param l Lumières
- * @param camera Caméra
- * @param projected_coordinates Coordonnées projetées des sommets
- * @param world_coordinates Coordonnées monde des sommets
- * @param Z_correction Correction de profondeur
- * @param tex Texture couleur
- * @param nTex Texture de normales
- * @param pTex Texture de parallax mapping
+ * @brief Cherche les centres de pixel couverts par un petit triangle
+ *
+ * Teste directement les quelques centres de la boîte englobante, avec exactement les mêmes
+ * fonctions d'arête que le parcours par lignes, avant tout travail sur les attributs.
+ * @param setup Triangle issu du setup (boîte d'au plus SmallTriangleMaxSamples pixels)
+ * @param screen Sommets écran
+ * @param out Centres couverts et leurs fonctions d'arête
+ * @return Nombre de centres couverts (0 : le triangle ne produit aucun pixel)
  */
-void Device::RasterizeTriangle(const mat4x4 &proj, const mat4x4 &world, const mat3x3 &normalMatrix, Face f, Mesh mesh, Lights l, std::shared_ptr<Camera> camera, vector<dvec3> projected_coordinates, vector<vec3> world_coordinates, vector<float> Z_correction, Textures &tex, TextureNormalMap &nTex, TextureParallaxMapping &pTex)
+static int CollectCoveredSamples(const SetupTriangle &setup, const vec3 screen[3], CoveredSample out[SmallTriangleMaxSamples])
 {
-    float Wrgb = 0.0f;
-    float Wr = 0.0f;
-    float Wg = 0.0f;
-    float Wb = 0.0f;
-    float Weight_RED = 0.0f;
-    float Weight_GREEN = 0.0f;
-    float Weight_BLUE = 0.0f;
-    bool write = true;
+    vec3 a = screen[0];
+    vec3 b = screen[1];
+    vec3 c = screen[2];
+    int count = 0;
 
-    vector<vec3> vertices = mesh.get_vertices();
-    vector<vec3> normals = mesh.get_normals();
-    vector<vec2> uv = mesh.get_uvs();
+    for (int y = setup.y0; y <= setup.y1; y++)
+    {
+        vec3 p(setup.x0 + 0.5f, y + 0.5f, 0.0);
+        float Weight_RED = ComputeEdgeFunction(b, c, p);
+        float Weight_GREEN = ComputeEdgeFunction(c, a, p);
+        float Weight_BLUE = ComputeEdgeFunction(a, b, p);
 
-    vec3 a = projected_coordinates[0];
-    vec3 b = projected_coordinates[1];
-    vec3 c = projected_coordinates[2];
+        for (int x = setup.x0; x <= setup.x1; x++)
+        {
+            if (Weight_RED >= 0.0f && Weight_GREEN >= 0.0f && Weight_BLUE >= 0.0f)
+                out[count++] = {x, y, {Weight_RED, Weight_GREEN, Weight_BLUE}};
 
-    float wa = Z_correction[0];
-    float wb = Z_correction[1];
-    float wc = Z_correction[2];
+            Weight_RED = Weight_RED + c.y - b.y;
+            Weight_GREEN = Weight_GREEN + a.y - c.y;
+            Weight_BLUE = Weight_BLUE + b.y - a.y;
+        }
+    }
 
-    Wrgb = ComputeEdgeFunction(a, b, c);
+    return count;
+}
 
-    float x_max = MaxOfThree(a.x, b.x, c.x);
-    float x_min = MinOfThree(a.x, b.x, c.x);
+/**
+ * @brief Mesure l'empreinte à l'écran des faces d'un lot de meshlets visibles
+ *
+ * Pour chaque arête, rapport entre sa longueur à l'écran et sa longueur en coordonnées de texture ;
+ * une texture qui a au moins autant de texels par unité de uv n'est jamais agrandie.
+ * @param me Sous-mesh
+ * @param visible Meshlets visibles du lot
+ * @param count Nombre de meshlets visibles
+ * @param screen Positions écran des sommets du sous-mesh (relatives à firstVertex)
+ * @param outcodes Codes de découpage des sommets
+ * @param uvs Coordonnées de texture du Mesh
+ * @return Pixels par unité de uv ; FullResolution si une face traverse le plan near
+ */
+static float ScreenUvDensity(const MeshData &me, const int *visible, size_t count, const Vec3SoA &screen,
+                             const unsigned char *outcodes, const vector<vec2> &uvs)
+{
+    float density = 0.0f;
+    for (size_t n = 0; n < count; n++)
+    {
+        const Meshlet &meshlet = me.meshlets[visible[n]];
+        for (int j = meshlet.firstFace; j < meshlet.firstFace + meshlet.faceCount; j++)
+        {
+            const uint32_t *k = &me.indices[3 * j];
+            if ((outcodes[k[0]] | outcodes[k[1]] | outcodes[k[2]]) & OutcodeNear)
+                return FullResolution; // projection inutilisable : pleine résolution par prudence
+            for (int e = 0; e < 3; e++)
+            {
+                const uint32_t a = k[e], b = k[(e + 1) % 3];
+                const float uvLength = length(uvs[me.firstVertex + a] - uvs[me.firstVertex + b]);
+                if (uvLength > 1e-6f)
+                    density = std::max(density, length(vec2(screen.x[a] - screen.x[b], screen.y[a] - screen.y[b])) / uvLength);
+            }
+        }
+    }
+    return density;
+}
 
-    float y_max = MaxOfThree(a.y, b.y, c.y);
-    float y_min = MinOfThree(a.y, b.y, c.y);
+/**
+ * @brief Remplit un triangle à l'écran ligne par ligne
+ * @param t Données du triangle (setup, sommets, lumières, textures)
+ */
+void Device::RasterizeTriangle(TriangleShading &t)
+{
+    const SetupTriangle &setup = t.setup;
+    vec3 a = t.screen[0];
+    vec3 b = t.screen[1];
+    vec3 c = t.screen[2];
 
-    int x0 = static_cast<int>(std::max(0.0f, x_min));
-    int x1 = static_cast<int>(std::min(GetWidth() - 1.0f, x_max));
-    int y0 = static_cast<int>(std::max(0.0f, y_min));
-    int y1 = static_cast<int>(std::min(GetHeight() - 1.0f, y_max));
+    const int x0 = setup.x0;
+    const int x1 = setup.x1;
+    const int y0 = setup.y0;
+    const int y1 = setup.y1;
 
-    // To transform coordinate by rotation, translation and/or scaling from polygon.
-    vec3 a_world = world_coordinates[0];
-    vec3 b_world = world_coordinates[1];
-    vec3 c_world = world_coordinates[2];
+    const SimdKernels &simd = GetSimdKernels();
 
     // Here, it's possible to enhance with the multithreading
     for (int y = y0; y <= y1; y++)
@@ -190,178 +229,255 @@ void Device::RasterizeTriangle(const mat4x4 &proj, const mat4x4 &world, const ma
         vec3 p(x0 + 0.5f, y + 0.5f, 0.0);
 
         // Computing weights.
-        Weight_RED = ComputeEdgeFunction(b, c, p);
-        Weight_GREEN = ComputeEdgeFunction(c, a, p);
-        Weight_BLUE = ComputeEdgeFunction(a, b, p);
+        const float rowWeight[3] = {ComputeEdgeFunction(b, c, p), ComputeEdgeFunction(c, a, p), ComputeEdgeFunction(a, b, p)};
+
+        // Recherche vectorisée des pixels couverts sur la ligne. L'intervalle est élargi d'un pixel
+        // pour absorber les écarts d'arrondi : le test par pixel ci-dessous reste seul juge.
+        int first = 0;
+        int last = 0;
+        if (!simd.rasterSpan(rowWeight, setup.stepX, x1 - x0 + 1, &first, &last))
+            continue;
+        first = std::max(0, first - 1);
+        last = std::min(x1 - x0, last + 1);
+
+        // Avance incrémentale (sans test) pour garder exactement les mêmes poids que le parcours complet.
+        float Weight_RED = rowWeight[0];
+        float Weight_GREEN = rowWeight[1];
+        float Weight_BLUE = rowWeight[2];
+        for (int k = 0; k < first; k++)
+        {
+            Weight_RED = Weight_RED + c.y - b.y;
+            Weight_GREEN = Weight_GREEN + a.y - c.y;
+            Weight_BLUE = Weight_BLUE + b.y - a.y;
+        }
 
-        for (int x = x0; x <= x1; x++)
+        for (int x = x0 + first; x <= x0 + last; x++)
         {
             // The point is in the triangle.
             if (Weight_RED >= 0.0f && Weight_GREEN >= 0.0f && Weight_BLUE >= 0.0f)
             {
-                Wr = Weight_RED / Wrgb;
-                Wg = Weight_GREEN / Wrgb;
-                Wb = Weight_BLUE / Wrgb;
+                ShadePixel(x, y, Weight_RED, Weight_GREEN, Weight_BLUE, t);
+            }
 
-                float invW_interp = (Wr / wa) + (Wg / wb) + (Wb / wc);
+            Weight_RED = Weight_RED + c.y - b.y;
+            Weight_GREEN = Weight_GREEN + a.y - c.y;
+            Weight_BLUE = Weight_BLUE + b.y - a.y;
+        }
+    }
+}
 
-                float Z = a.z * Wr + b.z * Wg + c.z * Wb;
+/**
+ * @brief Ombre les centres de pixel déjà trouvés par CollectCoveredSamples (petits triangles)
+ * @param samples Centres couverts
+ * @param count Nombre de centres
+ * @param t Données du triangle
+ */
+void Device::ShadeSamples(const CoveredSample *samples, int count, TriangleShading &t)
+{
+    for (int s = 0; s < count; s++)
+    {
+        ShadePixel(samples[s].x, samples[s].y, samples[s].weight[0], samples[s].weight[1], samples[s].weight[2], t);
+    }
+}
 
-                // Test of Z-buffer.
-                if (Z > _depthbuffer[y * GetWidth() + x].load())
-                {
-                    write = false;
-                }
-                else
-                {
-                    _depthbuffer[y * GetWidth() + x].store(Z);
-                    float contrast = std::pow(Z, 2.5f);
-                    _imageZbuffer[y * GetWidth() + x] = static_cast<unsigned char>(contrast * 255.0f);
-                    write = true;
-                }
+/**
+ * @brief Interpole les attributs, teste le Z-buffer et ombre un pixel couvert par le triangle
+ * @param x,y Pixel
+ * @param Weight_RED,Weight_GREEN,Weight_BLUE Fonctions d'arête au centre du pixel
+ * @param t Données du triangle
+ */
+void Device::ShadePixel(int x, int y, float Weight_RED, float Weight_GREEN, float Weight_BLUE, TriangleShading &t)
+{
+    const SetupTriangle &setup = t.setup;
+    const Face &f = t.face;
+    Lights &l = t.light;
+    const std::shared_ptr<Camera> &camera = t.camera;
+    const mat3x3 &normalMatrix = t.normalMatrix;
+    const vector<vec3> &normals = t.normals;
+    const vector<vec2> &uv = t.uvs;
+    Textures &tex = t.tex;
+    TextureNormalMap &nTex = t.nTex;
+    TextureParallaxMapping &pTex = t.pTex;
+
+    const vec3 &a = t.screen[0];
+    const vec3 &b = t.screen[1];
+    const vec3 &c = t.screen[2];
+
+    // To transform coordinate by rotation, translation and/or scaling from polygon.
+    const vec3 &a_world = t.world[0];
+    const vec3 &b_world = t.world[1];
+    const vec3 &c_world = t.world[2];
+
+    // Inverses des w des sommets : multiplications au lieu de divisions par pixel.
+    const float invWa = setup.invW[0];
+    const float invWb = setup.invW[1];
+    const float invWc = setup.invW[2];
+
+    // Sous-triangle découpé : barycentriques de ses sommets dans la face d'origine.
+    const vec3 baryA{setup.bary[0][0], setup.bary[0][1], setup.bary[0][2]};
+    const vec3 baryB{setup.bary[1][0], setup.bary[1][1], setup.bary[1][2]};
+    const vec3 baryC{setup.bary[2][0], setup.bary[2][1], setup.bary[2][2]};
+
+    const float Wrgb = setup.area;
+
+    const float Wr = Weight_RED / Wrgb;
+    const float Wg = Weight_GREEN / Wrgb;
+    const float Wb = Weight_BLUE / Wrgb;
+
+    // Poids pondérés par 1/w (interpolation perspective) et poids des attributs de la face.
+    vec3 persp{Wr * invWa, Wg * invWb, Wb * invWc};
+    vec3 weight{Wr, Wg, Wb};
+    if (setup.clipped)
+    {
+        // Les attributs sont ceux de la face d'origine : on y ramène les poids du sous-triangle.
+        persp = baryA * persp.x + baryB * persp.y + baryC * persp.z;
+        weight = persp / (persp.x + persp.y + persp.z);
+    }
 
-                // Set variable "weight" by the weight computed previously.
-                vec3 weight{};
-                weight.x = Wr;
-                weight.y = Wg;
-                weight.z = Wb;
+    float invW_interp = persp.x + persp.y + persp.z;
 
-                // Draw the pixel
-                if (write)
-                {
-                    vec3 normalsA = normalize(normalMatrix * normals[f.A.IndiceNormals - 1]);
-                    vec3 normalsB = normalize(normalMatrix * normals[f.B.IndiceNormals - 1]);
-                    vec3 normalsC = normalize(normalMatrix * normals[f.C.IndiceNormals - 1]);
+    float Z = a.z * Wr + b.z * Wg + c.z * Wb;
+
+    // Test of Z-buffer.
+    if (Z > _depthbuffer[y * GetWidth() + x].load())
+    {
+        return;
+    }
+
+    _depthbuffer[y * GetWidth() + x].store(Z);
+    float contrast = std::pow(Z, 2.5f);
+    _imageZbuffer[y * GetWidth() + x] = static_cast<unsigned char>(contrast * 255.0f);
+
+    // Sommets uniques : position, normale et uv partagent le même indice.
+    const int ia = f.A.IndiceVertices - 1;
+    const int ib = f.B.IndiceVertices - 1;
+    const int ic = f.C.IndiceVertices - 1;
 
-                    _normalBuffer[y * GetWidth() + x] = normalsA * Wr + normalsB * Wg + normalsC * Wb;
+    // Draw the pixel
+    vec3 normalsA = normalize(normalMatrix * normals[ia]);
+    vec3 normalsB = normalize(normalMatrix * normals[ib]);
+    vec3 normalsC = normalize(normalMatrix * normals[ic]);
 
-                    _imageNormal[(y * GetWidth() + x) * 3] = (unsigned char)((_normalBuffer[y * GetWidth() + x].x * 0.5f + 0.5f) * 255.0f);
-                    _imageNormal[((y * GetWidth() + x) * 3) + 1] = (unsigned char)((_normalBuffer[y * GetWidth() + x].y * 0.5f + 0.5f) * 255.0f);
-                    _imageNormal[((y * GetWidth() + x) * 3) + 2] = (unsigned char)((_normalBuffer[y * GetWidth() + x].z * 0.5f + 0.5f) * 255.0f);
+    _normalBuffer[y * GetWidth() + x] = normalsA * weight.x + normalsB * weight.y + normalsC * weight.z;
 
-                    // Interpolation de la texture.
-                    float u = (uv[f.A.IndiceTexCoords - 1].x / wa * weight.x + uv[f.B.IndiceTexCoords - 1].x / wb * weight.y + uv[f.C.IndiceTexCoords - 1].x / wc * weight.z);
-                    float v = (uv[f.A.IndiceTexCoords - 1].y / wa * weight.x + uv[f.B.IndiceTexCoords - 1].y / wb * weight.y + uv[f.C.IndiceTexCoords - 1].y / wc * weight.z);
+    _imageNormal[(y * GetWidth() + x) * 3] = (unsigned char)((_normalBuffer[y * GetWidth() + x].x * 0.5f + 0.5f) * 255.0f);
+    _imageNormal[((y * GetWidth() + x) * 3) + 1] = (unsigned char)((_normalBuffer[y * GetWidth() + x].y * 0.5f + 0.5f) * 255.0f);
+    _imageNormal[((y * GetWidth() + x) * 3) + 2] = (unsigned char)((_normalBuffer[y * GetWidth() + x].z * 0.5f + 0.5f) * 255.0f);
+
+    // Interpolation de la texture.
+    float u = (uv[ia].x * persp.x + uv[ib].x * persp.y + uv[ic].x * persp.z);
+    float v = (uv[ia].y * persp.x + uv[ib].y * persp.y + uv[ic].y * persp.z);
 
 #pragma region Parallax Mapping
-                    mat3x3 TBN{};
-                    if (pTex.getLoaded() == true)
-                    {
-                        TBN = nTex.getTBN(f, a_world, b_world, c_world, uv, weight, normalMatrix);
-                        vec3 tangentialCamPos{};
-                        TransformVectorByMatrix3x3(camera->get_position(), transpose(TBN), tangentialCamPos);
-                        vec3 tangentialFragPos{};
-                        vec3 point3D_position = a_world * weight.x + b_world * weight.y + c_world * weight.z;
-                        TransformVectorByMatrix3x3(point3D_position, transpose(TBN), tangentialFragPos);
-
-                        vec3 viewDirection = tangentialCamPos - tangentialFragPos;
-
-                        pTex.setPixel(std::min(1.0f, u / (invW_interp)), std::min(1.0f, v / (invW_interp)));
-                        u = std::min(1.0f, std::max(0.0f, u / (invW_interp)));
-                        v = std::min(1.0f, std::max(0.0f, v / (invW_interp)));
-                        vec2 uv = {u, v};
-                        vec2 dis{};
-                        dis = pTex.getParallaxMapping(uv, normalize(viewDirection));
-
-                        if (dis.x <= 1.0f && dis.x >= 0.0f && dis.y <= 1.0f && dis.y >= 0.0f)
-                        {
-                            u = dis.x;
-                            v = dis.y;
-                        }
-                    }
+    mat3x3 TBN{};
+    if (pTex.getLoaded() == true)
+    {
+        TBN = nTex.getTBN(f, a_world, b_world, c_world, uv, weight, normalMatrix);
+        vec3 tangentialCamPos{};
+        TransformVectorByMatrix3x3(camera->get_position(), transpose(TBN), tangentialCamPos);
+        vec3 tangentialFragPos{};
+        vec3 point3D_position = a_world * weight.x + b_world * weight.y + c_world * weight.z;
+        TransformVectorByMatrix3x3(point3D_position, transpose(TBN), tangentialFragPos);
+
+        vec3 viewDirection = tangentialCamPos - tangentialFragPos;
+
+        pTex.setPixel(std::min(1.0f, u / (invW_interp)), std::min(1.0f, v / (invW_interp)));
+        u = std::min(1.0f, std::max(0.0f, u / (invW_interp)));
+        v = std::min(1.0f, std::max(0.0f, v / (invW_interp)));
+        vec2 uv = {u, v};
+        vec2 dis{};
+        dis = pTex.getParallaxMapping(uv, normalize(viewDirection));
+
+        if (dis.x <= 1.0f && dis.x >= 0.0f && dis.y <= 1.0f && dis.y >= 0.0f)
+        {
+            u = dis.x;
+            v = dis.y;
+        }
+    }
 #pragma endregion Parallax Mapping
 
-                    if (tex.getLoaded() == true)
-                    {
-                        if (pTex.getLoaded() == true)
-                        {
-                            tex.setPixel(u, v);
-                        }
-                        else
-                        {
-                            tex.setPixel(std::min(1.0f, u / (invW_interp)), std::min(1.0f, v / (invW_interp)));
-                        }
-                    }
-
-                    vec3 normalMap{};
-                    if (nTex.getLoaded() == true)
-                    {
+    if (tex.getLoaded() == true)
+    {
+        if (pTex.getLoaded() == true)
+        {
+            tex.setPixel(u, v);
+        }
+        else
+        {
+            tex.setPixel(std::min(1.0f, u / (invW_interp)), std::min(1.0f, v / (invW_interp)));
+        }
+    }
 
-                        if (pTex.getLoaded() == true)
-                        {
-                            nTex.setPixel(u, v);
-                            normalMap = nTex.GetPixelNormal(f, a_world, b_world, c_world, uv, weight, normalMatrix, true);
-                            normalMap = transpose(TBN) * normalMap;
-                        }
-                        else
-                        {
-                            nTex.setPixel(std::min(1.0f, u / (invW_interp)), std::min(1.0f, v / (invW_interp)));
-                            normalMap = nTex.GetPixelNormal(f, a_world, b_world, c_world, uv, weight, normalMatrix);
-                        }
-                        _normalBuffer[y * GetWidth() + x] = normalMap;
-                        _imageNormal[(y * GetWidth() + x) * 3] = (unsigned char)((normalMap.x * 0.5f + 0.5f) * 255.0f);
-                        _imageNormal[((y * GetWidth() + x) * 3) + 1] = (unsigned char)((normalMap.y * 0.5f + 0.5f) * 255.0f);
-                        _imageNormal[((y * GetWidth() + x) * 3) + 2] = (unsigned char)((normalMap.z * 0.5f + 0.5f) * 255.0f);
-                    }
+    vec3 normalMap{};
+    if (nTex.getLoaded() == true)
+    {
 
-                    if (nTex.getLoaded() == true)
-                    {
-                        l.preCompute(weight, a_world, b_world, c_world, normalMap, normalMap, normalMap);
-                        l.ComputeLightPhong(TBN, pTex.getLoaded());
-                        l.ComputeSpecular(camera->get_position(), 64, TBN, pTex.getLoaded());
-                    }
-                    else
-                    {
-                        l.preCompute(weight, a_world, b_world, c_world, normalsA, normalsB, normalsC);
-                        l.ComputeLightPhong();
-                        l.ComputeSpecular(camera->get_position(), 64);
-                    }
+        if (pTex.getLoaded() == true)
+        {
+            nTex.setPixel(u, v);
+            normalMap = nTex.GetPixelNormal(f, a_world, b_world, c_world, uv, weight, normalMatrix, true);
+            normalMap = transpose(TBN) * normalMap;
+        }
+        else
+        {
+            nTex.setPixel(std::min(1.0f, u / (invW_interp)), std::min(1.0f, v / (invW_interp)));
+            normalMap = nTex.GetPixelNormal(f, a_world, b_world, c_world, uv, weight, normalMatrix);
+        }
+        _normalBuffer[y * GetWidth() + x] = normalMap;
+        _imageNormal[(y * GetWidth() + x) * 3] = (unsigned char)((normalMap.x * 0.5f + 0.5f) * 255.0f);
+        _imageNormal[((y * GetWidth() + x) * 3) + 1] = (unsigned char)((normalMap.y * 0.5f + 0.5f) * 255.0f);
+        _imageNormal[((y * GetWidth() + x) * 3) + 2] = (unsigned char)((normalMap.z * 0.5f + 0.5f) * 255.0f);
+    }
 
-                    l.ComputeAttenuation("pointlight", 0.09f, 0.032f, 10.0f);
+    if (nTex.getLoaded() == true)
+    {
+        l.preCompute(weight, a_world, b_world, c_world, normalMap, normalMap, normalMap);
+        l.ComputeLightPhong(TBN, pTex.getLoaded());
+        l.ComputeSpecular(camera->get_position(), 64, TBN, pTex.getLoaded());
+    }
+    else
+    {
+        l.preCompute(weight, a_world, b_world, c_world, normalsA, normalsB, normalsC);
+        l.ComputeLightPhong();
+        l.ComputeSpecular(camera->get_position(), 64);
+    }
 
-                    float innerAngle = 12.5f;
-                    float outerAngle = 17.5f;
+    l.ComputeAttenuation("pointlight", 0.09f, 0.032f, 10.0f);
 
-                    float cutoff = cos(glm::radians(innerAngle));
-                    float outerCutoff = cos(glm::radians(outerAngle));
-                    l.ComputeSpotLight("spot", cutoff, outerCutoff);
+    float innerAngle = 12.5f;
+    float outerAngle = 17.5f;
 
-                    vec3 I = l.getIntensity(weight, f);
+    float cutoff = cos(glm::radians(innerAngle));
+    float outerCutoff = cos(glm::radians(outerAngle));
+    l.ComputeSpotLight("spot", cutoff, outerCutoff);
 
-                    if (tex.getLoaded() == true)
-                    {
-                        SetPixelColor(x, y, I.x * tex.getRed(), I.y * tex.getGreen(), I.z * tex.getBlue());
-                    }
-                    else
-                    {
-                        if (l.getConstantKd().x == 0 && l.getConstantKd().y == 0 && l.getConstantKd().z == 0)
-                        {
-                            SetPixelColor(x, y, I.x * 127.0f, I.y * 127.0f, I.z * 127.0f);
-                        }
-                        else
-                        {
-                            SetPixelColor(x, y, I.x * l.getConstantKd().x, I.y * l.getConstantKd().y, I.z * l.getConstantKd().z);
-                        }
-                    }
-                }
-            }
+    vec3 I = l.getIntensity(weight, f);
 
-            Weight_RED = Weight_RED + c.y - b.y;
-            Weight_GREEN = Weight_GREEN + a.y - c.y;
-            Weight_BLUE = Weight_BLUE + b.y - a.y;
+    if (tex.getLoaded() == true)
+    {
+        SetPixelColor(x, y, I.x * tex.getRed(), I.y * tex.getGreen(), I.z * tex.getBlue());
+    }
+    else
+    {
+        if (l.getConstantKd().x == 0 && l.getConstantKd().y == 0 && l.getConstantKd().z == 0)
+        {
+            SetPixelColor(x, y, I.x * 127.0f, I.y * 127.0f, I.z * 127.0f);
+        }
+        else
+        {
+            SetPixelColor(x, y, I.x * l.getConstantKd().x, I.y * l.getConstantKd().y, I.z * l.getConstantKd().z);
         }
     }
 }
 
 /**
- * @brief Lance le rendu de la scène complète
+ * @brief Construit les matrices de vue et de projection de l'image
  * @param camera Caméra
- * @param meshes Maillage
- * @param l Lumières
+ * @param view Matrice de vue (sortie)
+ * @param proj Matrice de projection (sortie)
  */
-void Device::RenderScene(std::shared_ptr<Camera> camera, Mesh meshes, Lights &l)
+void Device::BuildFrameMatrices(const std::shared_ptr<Camera> &camera, mat4x4 &view, mat4x4 &proj)
 {
-    mat4x4 proj, view;
     vec3 unitY{};
     unitY.x = 0.0f;
     unitY.y = 1.0f;
@@ -372,28 +488,143 @@ void Device::RenderScene(std::shared_ptr<Camera> camera, Mesh meshes, Lights &l)
     float scale = (static_cast<float>(GetWidth()) / static_cast<float>(GetHeight()));
 
     BuildPerspectiveMatrix(45.0f, scale, 1.0f, 100.0f, proj);
+}
+
+/**
+ * @brief Lance le rendu de la scène complète
+ * @param camera Caméra
+ * @param meshes Maillage
+ * @param l Lumières
+ */
+void Device::RenderScene(std::shared_ptr<Camera> camera, Mesh &meshes, Lights &l)
+{
+    mat4x4 proj, view;
+    BuildFrameMatrices(camera, view, proj);
 
-    mat4x4 T, Rx, Ry, Rz, Rm, S;
+    auto t_start = std::chrono::high_resolution_clock::now();
+
+    RenderStats stats;
+    RenderMesh(camera, meshes, l, view, proj, stats);
+
+    auto t_end = std::chrono::high_resolution_clock::now();
+    FinishFrame(camera, view, proj, stats, std::chrono::duration<double, std::milli>(t_end - t_start).count());
+}
+
+/**
+ * @brief Lance le rendu d'une scène chargée par blocs
+ * @param camera Caméra
+ * @param stream Flux de blocs ouvert
+ * @param l Lumières
+ *
+ * Les blocs dont la boîte coupe le frustum sont rendus du plus proche au plus lointain
+ * (le test de profondeur rejette plus tôt les pixels cachés) ; chacun n'est chargé
+ * qu'au moment de son rendu. Les positions des blocs sont en espace monde.
+ */
+void Device::RenderStream(std::shared_ptr<Camera> camera, MeshStream &stream, Lights &l)
+{
+    mat4x4 proj, view;
+    BuildFrameMatrices(camera, view, proj);
 
     auto t_start = std::chrono::high_resolution_clock::now();
 
-    vector<MeshData> md = meshes.get_meshData();
+    Frustum frustum;
+    frustum.extractFromMatrix(proj * view);
 
-    int i = 0;
-    for (MeshData me : md)
+    vector<pair<float, size_t>> visibleChunks;
+    for (size_t c = 0; c < stream.get_chunkCount(); c++)
     {
-        Rotation_X_Pitch(Rx, meshes.get_rotation(i).x);
-        Rotation_Y_Yaw(Ry, meshes.get_rotation(i).y);
-        Rotation_Z_Roll(Rz, meshes.get_rotation(i).z);
-        Rotation_XYZ_PitchYawRoll(Rx, Ry, Rz, Rm);
-        BuildTranslationMatrix(meshes.get_position(i), T);
-        Scale(1.0f, S);
-
-        const mat4x4 WorldMatrix = T * Rm * S;
-        const mat4x4 transformMatrix = proj * view * WorldMatrix;
+        const StreamChunk &chunk = stream.get_chunk(c);
+        const vec3 bbMin(chunk.bbMin[0], chunk.bbMin[1], chunk.bbMin[2]);
+        const vec3 bbMax(chunk.bbMax[0], chunk.bbMax[1], chunk.bbMax[2]);
+        if (chunk.faceCount == 0 || frustum.classifyAABB(bbMin, bbMax) < 0)
+            continue;
+        visibleChunks.push_back({length((bbMin + bbMax) * 0.5f - camera->get_position()), c});
+    }
+    std::sort(visibleChunks.begin(), visibleChunks.end());
+
+    const size_t loadsBefore = stream.get_loadCount();
+    RenderStats stats;
+    for (const pair<float, size_t> &chunk : visibleChunks)
+        RenderMesh(camera, stream.acquire(chunk.second), l, view, proj, stats);
+
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::cout << std::endl;
+    std::cout << "Chunks rendered : " << visibleChunks.size() << " / " << stream.get_chunkCount()
+              << " (loaded : " << stream.get_loadCount() - loadsBefore
+              << ", resident : " << stream.get_residentBytes() / (1024 * 1024) << " MB)";
+    FinishFrame(camera, view, proj, stats, std::chrono::duration<double, std::milli>(t_end - t_start).count());
+}
+
+/**
+ * @brief Rasterise tous les sous-meshes d'un Mesh dans les buffers de l'image
+ * @param camera Caméra
+ * @param meshes Maillage (meshlets et BVH construits)
+ * @param l Lumières
+ * @param view Matrice de vue
+ * @param proj Matrice de projection
+ * @param stats Compteurs de l'image, cumulés
+ */
+void Device::RenderMesh(const std::shared_ptr<Camera> &camera, Mesh &meshes, Lights &l, const mat4x4 &view, const mat4x4 &proj, RenderStats &stats)
+{
+    const vector<MeshData> &md = meshes.get_meshData();
+
+    // Culling hiérarchique : le BVH de la scène (en espace monde) ne renvoie
+    // que les meshlets dont la boîte intersecte le frustum de proj * view.
+    Frustum sceneFrustum;
+    sceneFrustum.extractFromMatrix(proj * view);
 
+    vector<vector<int>> visibleMeshlets(md.size());
+    meshes.get_bvh().collectVisible(sceneFrustum, visibleMeshlets);
+
+    stats.totalClusters += meshes.get_bvh().get_leafCount();
+    stats.culledClusters += meshes.get_bvh().get_leafCount();
+
+    // Culling des meshlets (frustum de l'objet, cône des normales) avant toute transformation de sommets.
+    // Seuls les lots qui gardent un meshlet visible chargent leurs textures : leur décodage est lancé ici
+    // en arrière-plan, et un matériau dont toute la géométrie est rejetée ne lit jamais ses fichiers.
+    for (int o = 0; o < static_cast<int>(md.size()); o++)
+    {
+        const MeshData &me = md[o];
+        const mat4x4 WorldMatrix = meshes.get_world_matrix(o);
         Frustum frustum;
-        frustum.extractFromMatrix(transformMatrix);
+        frustum.extractFromMatrix(proj * view * WorldMatrix);
+        // Le frustum est extrait de proj*view*world : il est exprimé dans l'espace
+        // objet, comme les sphères et les cônes des meshlets.
+        const vec3 cameraObject = vec3(inverse(WorldMatrix) * vec4(camera->get_position(), 1.0f));
+
+        // Meshlets visibles dans l'ordre : ceux d'un même lot de matériau se suivent.
+        vector<int> &visible = visibleMeshlets[o];
+        std::sort(visible.begin(), visible.end());
+        visible.erase(std::remove_if(visible.begin(), visible.end(), [&](int m)
+                                     { return frustum.isSphereOutside(me.meshlets[m].center, me.meshlets[m].radius) ||
+                                              me.meshlets[m].isBackFacing(cameraObject); }),
+                      visible.end());
+        stats.culledClusters -= static_cast<int>(visible.size());
+
+        size_t next = 0;
+        for (const MaterialBatch &batch : me.batches)
+        {
+            const size_t first = next;
+            while (next < visible.size() && visible[next] < batch.firstMeshlet + batch.meshletCount)
+                next++;
+            if (next > first && batch.material < me.material.size())
+                WarmTextures(me.material[batch.material]);
+        }
+    }
+
+    const SimdKernels &simd = GetSimdKernels();
+
+    int i = 0;
+    for (const MeshData &me : md)
+    {
+        if (visibleMeshlets[i].empty())
+        {
+            i++;
+            continue; // objet entièrement rejeté : aucun sommet à transformer
+        }
+
+        const mat4x4 WorldMatrix = meshes.get_world_matrix(i);
+        const mat4x4 transformMatrix = proj * view * WorldMatrix;
 
         // Extraire la matrice 3x3 (rotation + échelle) de WorldMatrix
         mat3x3 normalMatrix = mat3x3(WorldMatrix);
@@ -401,154 +632,248 @@ void Device::RenderScene(std::shared_ptr<Camera> camera, Mesh meshes, Lights &l)
         // Calculer l'inverse-transpose
         normalMatrix = transpose(inverse(normalMatrix));
 
-        vector<dvec3> projected_coordinates{};
-        vector<vec3> world_coordinates{};
-        vector<float> Z_correction{};
-        vector<float> xy_min{};
-        vector<float> xy_max{};
+        const vector<vec3> &normals = meshes.get_normals();
+        const vector<vec2> &uvs = meshes.get_uvs();
 
-        int j = 0;
         ThreadPool threadPool(4);
 
-        for (const Face &face : me.faces)
+        // Transformation par lots de tous les vertices de l'objet (SoA) :
+        // positions monde, coordonnées clip, puis coordonnées écran.
+        const Vec3SoA &positions = meshes.get_vertices_soa();
+        const int firstVertex = me.firstVertex;
+        const size_t vertexCount = me.vertexCount;
+
+        Vec3SoA worldPositions, clipPositions, screenPositions;
+        worldPositions.resize(vertexCount);
+        clipPositions.resize(vertexCount);
+        screenPositions.resize(vertexCount);
+        vector<float> clipW(vertexCount);
+
+        TransformPositionsSoA(&positions.x[firstVertex], &positions.y[firstVertex], &positions.z[firstVertex], vertexCount,
+                              WorldMatrix, worldPositions.x.data(), worldPositions.y.data(), worldPositions.z.data(), clipW.data());
+        TransformPositionsSoA(&positions.x[firstVertex], &positions.y[firstVertex], &positions.z[firstVertex], vertexCount,
+                              transformMatrix, clipPositions.x.data(), clipPositions.y.data(), clipPositions.z.data(), clipW.data());
+        ProjectClipToViewportSoA(clipPositions.x.data(), clipPositions.y.data(), clipPositions.z.data(), clipW.data(), vertexCount,
+                                 static_cast<float>(GetWidth()), static_cast<float>(GetHeight()),
+                                 screenPositions.x.data(), screenPositions.y.data(), screenPositions.z.data());
+
+        vector<unsigned char> outcodes(vertexCount);
+        ComputeClipOutcodes(clipPositions.x.data(), clipPositions.y.data(), clipPositions.z.data(), clipW.data(), vertexCount, outcodes.data());
+
+        // Meshlets qui ont passé le culling, triés par lot de matériau.
+        const vector<int> &visible = visibleMeshlets[i];
+
+        // Empreinte à l'écran des lots visibles, connue dès la projection des sommets : leurs textures
+        // sont décodées au niveau qui leur suffit pendant la rasterisation des lots précédents.
+        vector<float> batchPixelsPerUv(me.batches.size(), FullResolution);
+        for (size_t b = 0, next = 0; b < me.batches.size(); b++)
         {
-            l.setConstantLight(meshes.get_ConstantLight(i, j));
-
-            vector<vec3> vertices = meshes.get_vertices();
-
-            // 1. Récupérer les 3 sommets du triangle en espace monde
-            vec3 a_world, b_world, c_world;
-            TransformVectorByMatrix4x4(vertices[face.A.IndiceVertices - 1], WorldMatrix, a_world);
-            TransformVectorByMatrix4x4(vertices[face.B.IndiceVertices - 1], WorldMatrix, b_world);
-            TransformVectorByMatrix4x4(vertices[face.C.IndiceVertices - 1], WorldMatrix, c_world);
-
-            // ========== FRUSTUM CULLING (NOUVEAU) ==========
-            if (frustum.isTriangleOutside(a_world, b_world, c_world))
-            {
-                j++;
-                continue; // Triangle hors du frustum
-            }
-            // ================================================
-
-            // ========== BACKFACE CULLING ==========
+            const MaterialBatch &batch = me.batches[b];
+            const size_t first = next;
+            while (next < visible.size() && visible[next] < batch.firstMeshlet + batch.meshletCount)
+                next++;
+            if (next == first || batch.material >= me.material.size())
+                continue;
+            const MaterialProperty &material = me.material[batch.material];
+            if (material.pathTexture.empty() && material.pathTextureBump.empty() && material.pathTextureDisp.empty())
+                continue;
+            batchPixelsPerUv[b] = ScreenUvDensity(me, &visible[first], next - first, screenPositions, outcodes.data(), uvs);
+            PrefetchTextures(material, batchPixelsPerUv[b]);
+        }
 
-            // 2. Calculer la normale de la face en espace monde
-            vec3 edge1 = {b_world.x - a_world.x, b_world.y - a_world.y, b_world.z - a_world.z};
-            vec3 edge2 = {c_world.x - a_world.x, c_world.y - a_world.y, c_world.z - a_world.z};
+        // Index buffer de l'objet (relatif à firstVertex), construit au chargement.
+        const vector<uint32_t> &triangleIndices = me.indices;
 
-            // Produit vectoriel pour obtenir la normale
-            vec3 faceNormal = {
-                edge1.y * edge2.z - edge1.z * edge2.y,
-                edge1.z * edge2.x - edge1.x * edge2.z,
-                edge1.x * edge2.y - edge1.y * edge2.x};
+        TriangleSetupInput setupInput{screenPositions.x.data(), screenPositions.y.data(), clipW.data(), outcodes.data(),
+                                      triangleIndices.data(), static_cast<float>(GetWidth()), static_cast<float>(GetHeight()),
+                                      OutcodeNear, GuardBand};
+        vector<SetupTriangle> survivors(Meshlet::MaxFaces);
+        vector<int> clipList(Meshlet::MaxFaces);
 
-            // Normaliser
-            float length = sqrt(faceNormal.x * faceNormal.x +
-                                faceNormal.y * faceNormal.y +
-                                faceNormal.z * faceNormal.z);
+        // Matériau, lumières et textures du lot en cours, résolus une fois pour toutes ses faces.
+        MaterialShading *batchShading = nullptr;
 
-            if (length > 0.0f)
+        // Rasterise un triangle issu du setup. Pour un sous-triangle découpé, "screen" contient
+        // ses propres sommets écran ; les attributs restent ceux de la face d'origine j.
+        auto rasterize = [&](int j, const SetupTriangle &setup, const vec3 screen[3])
+        {
+            // Petit triangle : ses quelques centres de pixel sont testés directement. S'il n'en
+            // couvre aucun, il est abandonné avant toute copie de lumières ou lecture de texture.
+            CoveredSample samples[SmallTriangleMaxSamples];
+            int sampleCount = -1;
+            if ((setup.x1 - setup.x0 + 1) * (setup.y1 - setup.y0 + 1) <= SmallTriangleMaxSamples)
             {
-                faceNormal.x /= length;
-                faceNormal.y /= length;
-                faceNormal.z /= length;
+                sampleCount = CollectCoveredSamples(setup, screen, samples);
+                if (sampleCount == 0)
+                {
+                    stats.emptyTriangles++;
+                    return;
+                }
+                stats.smallTriangles++;
             }
 
-            // 3. Calculer le vecteur vers la caméra
-            vec3 centroid = {
-                (a_world.x + b_world.x + c_world.x) / 3.0f,
-                (a_world.y + b_world.y + c_world.y) / 3.0f,
-                (a_world.z + b_world.z + c_world.z) / 3.0f};
+            const uint32_t ka = triangleIndices[3 * j];
+            const uint32_t kb = triangleIndices[3 * j + 1];
+            const uint32_t kc = triangleIndices[3 * j + 2];
 
-            vec3 cameraPos = camera->get_position();
-            vec3 toCamera = {
-                cameraPos.x - centroid.x,
-                cameraPos.y - centroid.y,
-                cameraPos.z - centroid.z};
+            MaterialShading &material = *batchShading;
 
-            // Normaliser toCamera
-            length = sqrt(toCamera.x * toCamera.x +
-                          toCamera.y * toCamera.y +
-                          toCamera.z * toCamera.z);
+            TriangleShading shading{me.faces[j], normals, uvs, normalMatrix, setup,
+                                    {screen[0], screen[1], screen[2]},
+                                    {vec3{worldPositions.x[ka], worldPositions.y[ka], worldPositions.z[ka]},
+                                     vec3{worldPositions.x[kb], worldPositions.y[kb], worldPositions.z[kb]},
+                                     vec3{worldPositions.x[kc], worldPositions.y[kc], worldPositions.z[kc]}},
+                                    material.light, camera, material.tex, material.nTex, material.pTex};
 
-            if (length > 0.0f)
-            {
-                toCamera.x /= length;
-                toCamera.y /= length;
-                toCamera.z /= length;
-            }
+            if (sampleCount >= 0)
+                ShadeSamples(samples, sampleCount, shading);
+            else
+                RasterizeTriangle(shading);
+        };
 
-            // 4. Produit scalaire pour le test de visibilité
-            float dotProduct = faceNormal.x * toCamera.x +
-                               faceNormal.y * toCamera.y +
-                               faceNormal.z * toCamera.z;
+        size_t next = 0;
 
-            // 5. Si la face est orientée vers l'arrière, on la skip
-            if (dotProduct < 0.0f)
+        for (size_t b = 0; b < me.batches.size(); b++)
+        {
+            const MaterialBatch &batch = me.batches[b];
+            size_t batchEnd = next;
+            while (batchEnd < visible.size() && visible[batchEnd] < batch.firstMeshlet + batch.meshletCount)
+                batchEnd++;
+            if (batchEnd == next)
+                continue; // aucun meshlet visible : ni matériau ni textures à charger
+
+            // Textures décodées à la résolution que demandent les meshlets visibles du lot.
+            const ConstantLight batchMaterial = meshes.get_MaterialConstantLight(i, batch.material);
+            MaterialShading batchResources(l, batchMaterial, batchPixelsPerUv[b]);
+            batchShading = &batchResources;
+
+            for (; next < batchEnd; next++)
             {
-                j++;
-                continue; // Face arrière, on ne la rasterise pas
-            }
+                const Meshlet &meshlet = me.meshlets[visible[next]];
 
-            // ========== FIN BACKFACE CULLING ==========
+                // ========== TRIANGLE SETUP ==========
+                // Faces arrière (aire signée écran), hors frustum et hors écran rejetées par lots ;
+                // seuls les survivants compactés passent à la rasterisation.
+                if (survivors.size() < static_cast<size_t>(meshlet.faceCount))
+                {
+                    survivors.resize(meshlet.faceCount);
+                    clipList.resize(meshlet.faceCount);
+                }
+                setupInput.indices = &triangleIndices[3 * meshlet.firstFace];
+                size_t clipCount = 0;
+                const size_t survivorCount = simd.triangleSetup(setupInput, meshlet.faceCount, survivors.data(), clipList.data(), &clipCount);
+                stats.setupTriangles += meshlet.faceCount;
+                stats.rasterizedTriangles += survivorCount;
 
-            vec3 a, b, c;
-            Z_correction.push_back(Projection_3D_to_2D(vertices[face.A.IndiceVertices - 1], transformMatrix, a));
-            projected_coordinates.push_back(a);
-            Z_correction.push_back(Projection_3D_to_2D(vertices[face.B.IndiceVertices - 1], transformMatrix, b));
-            projected_coordinates.push_back(b);
-            Z_correction.push_back(Projection_3D_to_2D(vertices[face.C.IndiceVertices - 1], transformMatrix, c));
-            projected_coordinates.push_back(c);
+                for (size_t s = 0; s < survivorCount; s++)
+                {
+                    const SetupTriangle &setup = survivors[s];
+                    const int j = meshlet.firstFace + setup.index;
+                    const uint32_t *k = &triangleIndices[3 * j];
 
-            xy_max.push_back(MaxOfThree(a.x, b.x, c.x));
-            xy_min.push_back(MinOfThree(a.x, b.x, c.x));
-            xy_max.push_back(MaxOfThree(a.y, b.y, c.y));
-            xy_min.push_back(MinOfThree(a.y, b.y, c.y));
+                    const vec3 screen[3] = {
+                        {screenPositions.x[k[0]], screenPositions.y[k[0]], screenPositions.z[k[0]]},
+                        {screenPositions.x[k[1]], screenPositions.y[k[1]], screenPositions.z[k[1]]},
+                        {screenPositions.x[k[2]], screenPositions.y[k[2]], screenPositions.z[k[2]]}};
 
-            if (xy_min[0] > GetWidth() - 1.0f || xy_max[0] < 0.0f ||
-                xy_min[1] > GetHeight() - 1.0f || xy_max[1] < 0.0f)
-            {
-                projected_coordinates.clear();
-                Z_correction.clear();
-                xy_min.clear();
-                xy_max.clear();
-                j++;
-                continue;
-            }
+                    rasterize(j, setup, screen);
+                }
 
-            world_coordinates.push_back(a_world);
-            world_coordinates.push_back(b_world);
-            world_coordinates.push_back(c_world);
+                // ========== CLIPPING ==========
+                // Triangles traversant le plan near ou sortant de la bande de garde : découpage en
+                // espace clip, puis setup des sous-triangles (en éventail) avant rasterisation.
+                for (size_t t = 0; t < clipCount; t++)
+                {
+                    const int j = meshlet.firstFace + clipList[t];
+                    const uint32_t *k = &triangleIndices[3 * j];
+
+                    const vec4 clip[3] = {
+                        {clipPositions.x[k[0]], clipPositions.y[k[0]], clipPositions.z[k[0]], clipW[k[0]]},
+                        {clipPositions.x[k[1]], clipPositions.y[k[1]], clipPositions.z[k[1]], clipW[k[1]]},
+                        {clipPositions.x[k[2]], clipPositions.y[k[2]], clipPositions.z[k[2]], clipW[k[2]]}};
+
+                    ClipVertex polygon[MaxClipVertices];
+                    const int polygonSize = ClipTriangle(clip, polygon);
+                    if (polygonSize < 3)
+                        continue;
+                    stats.clippedTriangles++;
+
+                    float polyX[MaxClipVertices], polyY[MaxClipVertices], polyZ[MaxClipVertices], polyW[MaxClipVertices];
+                    unsigned char polyCodes[MaxClipVertices] = {};
+                    uint32_t fan[3 * (MaxClipVertices - 2)];
+                    for (int v = 0; v < polygonSize; v++)
+                    {
+                        polyX[v] = polygon[v].position.x;
+                        polyY[v] = polygon[v].position.y;
+                        polyZ[v] = polygon[v].position.z;
+                        polyW[v] = polygon[v].position.w;
+                    }
+                    for (int v = 1; v + 1 < polygonSize; v++)
+                    {
+                        fan[3 * (v - 1)] = 0;
+                        fan[3 * (v - 1) + 1] = v;
+                        fan[3 * (v - 1) + 2] = v + 1;
+                    }
 
-            Lights localLight = Lights(l);
-            localLight.setConstantLight(meshes.get_ConstantLight(i, j));
+                    ProjectClipToViewportSoA(polyX, polyY, polyZ, polyW, polygonSize,
+                                             static_cast<float>(GetWidth()), static_cast<float>(GetHeight()), polyX, polyY, polyZ);
 
-            /*   threadPool.enqueue([this, transformMatrix, WorldMatrix, normalMatrix, face, meshes, localLight, camera,
-                                   projected_coordinates, world_coordinates, Z_correction]()
-                                  {*/
+                    // Le polygone est déjà dans le plan near et la bande de garde (tolérance doublée pour
+                    // les arrondis) : le setup ne renvoie jamais un sous-triangle au découpage.
+                    TriangleSetupInput clippedInput{polyX, polyY, polyW, polyCodes, fan,
+                                                    static_cast<float>(GetWidth()), static_cast<float>(GetHeight()), 0, GuardBand * 2.0f};
+                    SetupTriangle subTriangles[MaxClipVertices - 2];
+                    int subClipList[MaxClipVertices - 2];
+                    size_t subClipCount = 0;
+                    const size_t subCount = simd.triangleSetup(clippedInput, polygonSize - 2, subTriangles, subClipList, &subClipCount);
 
-            Textures tex = Textures(localLight.getPathTexture());
-            TextureNormalMap nTex = TextureNormalMap(localLight.getPathTextureBump());
-            TextureParallaxMapping pTex = TextureParallaxMapping(localLight.getPathTextureDisp(), 0.15f);
+                    for (size_t s = 0; s < subCount; s++)
+                    {
+                        SetupTriangle &setup = subTriangles[s];
+                        const uint32_t *f = &fan[3 * setup.index];
+                        setup.clipped = true;
+                        for (int v = 0; v < 3; v++)
+                        {
+                            setup.bary[v][0] = polygon[f[v]].bary.x;
+                            setup.bary[v][1] = polygon[f[v]].bary.y;
+                            setup.bary[v][2] = polygon[f[v]].bary.z;
+                        }
 
-            RasterizeTriangle(transformMatrix, WorldMatrix, normalMatrix, face, meshes, localLight, camera,
-                              projected_coordinates, world_coordinates, Z_correction, tex, nTex, pTex); //});
+                        const vec3 screen[3] = {
+                            {polyX[f[0]], polyY[f[0]], polyZ[f[0]]},
+                            {polyX[f[1]], polyY[f[1]], polyZ[f[1]]},
+                            {polyX[f[2]], polyY[f[2]], polyZ[f[2]]}};
 
-            projected_coordinates.clear();
-            world_coordinates.clear();
-            Z_correction.clear();
-            xy_min.clear();
-            xy_max.clear();
-            j++;
+                        rasterize(j, setup, screen);
+                    }
+                }
+            }
         }
 
         i++;
     }
+}
 
-    auto t_end = std::chrono::high_resolution_clock::now();
-    auto renderingTime = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+/**
+ * @brief Affiche les compteurs de l'image, écrit les images de sortie et applique les réflexions
+ * @param camera Caméra
+ * @param view Matrice de vue
+ * @param proj Matrice de projection
+ * @param stats Compteurs de l'image
+ * @param renderingTime Durée de la rasterisation en millisecondes
+ */
+void Device::FinishFrame(const std::shared_ptr<Camera> &camera, const mat4x4 &view, const mat4x4 &proj, const RenderStats &stats, double renderingTime)
+{
     std::cout << std::endl;
     std::cout << "Total rendering time : " << (renderingTime / 1000) << " s" << std::endl;
+    std::cout << "Clusters culled : " << stats.culledClusters << " / " << stats.totalClusters << std::endl;
+    std::cout << "Triangles rasterized : " << stats.rasterizedTriangles << " / " << stats.setupTriangles
+              << " (clipped : " << stats.clippedTriangles << ", small : " << stats.smallTriangles
+              << ", no sample covered : " << stats.emptyTriangles << ")" << std::endl;
+    VirtualTexturePool& virtualTextures = GetVirtualTexturePool();
+    if (virtualTextures.get_loadCount() > 0)
+        std::cout << "Virtual texture tiles loaded : " << virtualTextures.get_loadCount()
+                  << " (resident : " << virtualTextures.get_residentBytes() / (1024 * 1024) << " MB)" << std::endl;
 
     std::filesystem::create_directories("./RenderedImages");
 
@@ -616,10 +941,65 @@ vec3 FresnelSchlick(float cosTheta, vec3 F0)
     return F0 + (1.0f - F0) * std::pow(glm::clamp(1.0f - cosTheta, 0.0f, 1.0f), 5.0f);
 }
 
+/**
+ * @brief Pyramide de profondeurs minimales (Hi-Z) : le niveau 0 est la profondeur linéaire de l'écran,
+ * chaque niveau suivant garde le minimum de 2x2 texels du précédent, jusqu'à un seul texel
+ * @param linearDepth Profondeur linéaire de chaque pixel
+ * @param width,height Dimensions de l'écran
+ * @param unreachable Profondeur en dessous de laquelle un pixel ne peut pas être touché par un rayon
+ */
+vector<vector<float>> BuildMinDepthPyramid(const vector<float> &linearDepth, int width, int height, float unreachable)
+{
+    vector<vector<float>> levels(1, linearDepth);
+    // Pixels qu'aucun rayon ne peut toucher (fond, surfaces devant le plan near) : ils ne bloquent pas les sauts.
+    for (float &depth : levels[0])
+        if (depth < unreachable)
+            depth = std::numeric_limits<float>::infinity();
+
+    int w = width, h = height;
+    while (w > 1 || h > 1)
+    {
+        const int nw = (w + 1) / 2, nh = (h + 1) / 2;
+        const vector<float> &fine = levels.back();
+        vector<float> coarse(static_cast<size_t>(nw) * nh);
+        for (int y = 0; y < nh; y++)
+            for (int x = 0; x < nw; x++)
+            {
+                const int x0 = 2 * x, y0 = 2 * y;
+                const int x1 = std::min(x0 + 1, w - 1), y1 = std::min(y0 + 1, h - 1);
+                coarse[y * nw + x] = std::min(std::min(fine[y0 * w + x0], fine[y0 * w + x1]),
+                                              std::min(fine[y1 * w + x0], fine[y1 * w + x1]));
+            }
+        levels.push_back(std::move(coarse));
+        w = nw;
+        h = nh;
+    }
+    return levels;
+}
+
 void Device::ApplyScreenSpaceReflections(const std::shared_ptr<Camera> &camera, const mat4x4 &view, const mat4x4 &proj)
 {
     std::cout << "Starting SSR..." << std::endl;
     mat4x4 invProjView = inverse(proj * view);
+    const mat4x4 projView = proj * view;
+
+    const float near = 1.0f;
+    const float far = 100.0f;
+    const float thickness = 0.1f; // épaisseur supposée des surfaces derrière le Z-buffer
+    const int maxSteps = 1024; // garde-fou : une marche typique en fait quelques dizaines
+
+    // Profondeur linéaire de tout l'écran calculée en une passe vectorisée, puis pyramide Hi-Z :
+    // un texel du niveau k donne la surface la plus proche de 2^k x 2^k pixels.
+    vector<float> linearDepth(_width * _height);
+    for (size_t i = 0; i < linearDepth.size(); i++)
+        linearDepth[i] = _depthbuffer[i].load();
+    GetSimdKernels().linearizeDepth(linearDepth.data(), linearDepth.size(), near, far, linearDepth.data());
+    // Le rayon reste entre les plans near et far : une surface plus proche que near - thickness n'est jamais touchée.
+    const vector<vector<float>> hiZ = BuildMinDepthPyramid(linearDepth, _width, _height, near - thickness);
+    const int topLevel = static_cast<int>(hiZ.size()) - 1;
+
+    size_t tracedRays = 0;
+    size_t totalSteps = 0;
 
     for (int y = 0; y < _height; y++)
     {
@@ -652,110 +1032,101 @@ void Device::ApplyScreenSpaceReflections(const std::shared_ptr<Camera> &camera,
 
             vec3 startRay = positionWorld + reflection * 0.02f;
 
-            // CALCUL DE LA DISTANCE MAX ET DU STEP
-            vec4 startNdc = proj * view * vec4{startRay, 1.0f};
-            startNdc /= startNdc.w;
-
-            // Point de départ en coordonnées écran [0,1]
-            vec2 startUV{
-                (startNdc.x + 1.0f) * 0.5f,
-                (-startNdc.y + 1.0f) * 0.5f};
-
-            // Direction du rayon en NDC
-            vec4 endPointWorld = vec4{startRay + reflection, 1.0f};
-            vec4 endPointNdc = proj * view * endPointWorld;
-            endPointNdc /= endPointNdc.w;
-
-            vec2 endUV{
-                (endPointNdc.x + 1.0f) * 0.5f,
-                (-endPointNdc.y + 1.0f) * 0.5f};
-
-            // Vecteur de réflexion en espace écran
-            vec2 reflectionScreenSpace = endUV - startUV;
-
-            // Calculer la distance jusqu'aux bords de l'écran
-            vec2 rayDir2D = normalize(reflectionScreenSpace);
-
-            // Calculer la distance jusqu'au bord dans chaque direction
-            float distX = (rayDir2D.x > 0.0f ? 1.0f - startUV.x : startUV.x) / (abs(rayDir2D.x) + 1e-6f);
-            float distY = (rayDir2D.y > 0.0f ? 1.0f - startUV.y : startUV.y) / (abs(rayDir2D.y) + 1e-6f);
-
-            float distance_max = std::min(distX, distY);
-            distance_max = std::min(distance_max, sqrtf(2.0f)); // Limiter à la diagonale écran
-            distance_max = std::max(distance_max, 0.01f);       // Minimum de sécurité
-
-            // Longueur du vecteur de réflexion en espace écran
-            float reflectionLength = length(reflectionScreenSpace);
-            if (reflectionLength < 1e-6f)
-                continue; // Éviter division par zéro
-
-            // === NOUVEAU CALCUL STEPSIZE EN ESPACE MONDE ===
-            // Calculer la distance monde correspondant à distance_max écran
-            vec3 rayEndWorld = startRay + reflection * 100.0f; // Point loin sur le rayon (100 unités monde)
-            vec4 rayEndNdc = proj * view * vec4{rayEndWorld, 1.0f};
-            rayEndNdc /= rayEndNdc.w;
-
-            vec2 rayEndUV{
-                (rayEndNdc.x + 1.0f) * 0.5f,
-                (-rayEndNdc.y + 1.0f) * 0.5f};
-
-            // Distance écran pour 100 unités monde
-            float screenDistFor100 = length(rayEndUV - startUV);
-
-            // Ratio monde/écran
-            float worldPerScreen = 100.0f / (screenDistFor100 + 1e-6f); // Éviter division par zéro
-
-            // Distance monde max
-            float maxWorldDistance = distance_max * worldPerScreen;
-
-            // StepSize en MONDE
-            int maxStep = 4000;
-            float stepSize = maxWorldDistance / static_cast<float>(maxStep);
-
-            vec3 curPos = startRay;
+            // Rayon borné aux plans near et far (en espace vue, la caméra regarde vers -z).
+            const vec4 startView = view * vec4{startRay, 1.0f};
+            const vec4 directionView = view * vec4{reflection, 0.0f};
+            if (startView.z > -near || startView.z < -far)
+                continue;
+            float rayLength = 2.0f * far;
+            if (directionView.z > 1e-6f)
+                rayLength = std::min(rayLength, (-near - startView.z) / directionView.z);
+            else if (directionView.z < -1e-6f)
+                rayLength = std::min(rayLength, (-far - startView.z) / directionView.z);
+
+            // Extrémités du rayon à l'écran, en pixels, et leurs profondeurs linéaires : entre les deux,
+            // l'inverse de la profondeur varie linéairement avec la position à l'écran.
+            vec4 startClip = projView * vec4{startRay, 1.0f};
+            vec4 endClip = projView * vec4{startRay + reflection * rayLength, 1.0f};
+            startClip /= startClip.w;
+            endClip /= endClip.w;
+            const vec2 startPixel{GetWidth() * (startClip.x + 1.0f) * 0.5f, GetHeight() * (-startClip.y + 1.0f) * 0.5f};
+            const vec2 endPixel{GetWidth() * (endClip.x + 1.0f) * 0.5f, GetHeight() * (-endClip.y + 1.0f) * 0.5f};
+            const vec2 delta = endPixel - startPixel;
+            const float invDepthStart = 1.0f / LinearizeDepth(startClip.z * 0.5f + 0.5f, near, far);
+            const float invDepthDelta = 1.0f / LinearizeDepth(endClip.z * 0.5f + 0.5f, near, far) - invDepthStart;
+
+            if (startPixel.x < 0.0f || startPixel.x >= GetWidth() || startPixel.y < 0.0f || startPixel.y >= GetHeight())
+                continue;
+            const float pixelLength = std::max(std::abs(delta.x), std::abs(delta.y));
+            if (pixelLength < 1e-3f)
+                continue;
 
+            // Paramètre de sortie de l'écran le long du segment.
+            float tEnd = 1.0f;
+            if (delta.x > 0.0f)
+                tEnd = std::min(tEnd, (GetWidth() - startPixel.x) / delta.x);
+            else if (delta.x < 0.0f)
+                tEnd = std::min(tEnd, -startPixel.x / delta.x);
+            if (delta.y > 0.0f)
+                tEnd = std::min(tEnd, (GetHeight() - startPixel.y) / delta.y);
+            else if (delta.y < 0.0f)
+                tEnd = std::min(tEnd, -startPixel.y / delta.y);
+            // Petit pas au-delà d'une frontière de cellule, pour entrer dans la suivante.
+            const float nudge = 0.01f / pixelLength;
+
+            // Parcours hiérarchique : une cellule dont toutes les surfaces sont derrière le rayon est sautée
+            // d'un coup et le niveau remonte ; sinon on descend, jusqu'au pixel où se fait le test de la marche.
             bool hit = false;
             vec3 hitColor{};
-            float prevPosZ = startNdc.z * 0.5f + 0.5f;
-
-            for (int i = 1; i < maxStep; i++)
+            int level = 0;
+            float t = 0.0f;
+            int steps = 0;
+            while (t < tEnd && steps < maxSteps)
             {
-
-                vec4 curPos4{curPos, 1.0f};
-                vec4 curPosNdc = proj * view * curPos4;
-                curPosNdc /= curPosNdc.w;
-
-                if (curPosNdc.x < -1.0f || curPosNdc.x > 1.0f ||
-                    curPosNdc.y < -1.0f || curPosNdc.y > 1.0f ||
-                    curPosNdc.z < -1.0f || curPosNdc.z > 1.0f)
-                    break;
-
-                int screenX = GetWidth() * (curPosNdc.x + 1.0f) * 0.5f;
-                int screenY = GetHeight() * (-curPosNdc.y + 1.0f) * 0.5f;
-
-                if (screenX < 0 || screenX >= GetWidth() || screenY < 0 || screenY >= GetHeight())
-                    break;
-
-                float pixelDepth = GetPixelDepth(screenX, screenY);
-                float curPosZ = curPosNdc.z * 0.5f + 0.5f;
-
-                float linearPixelDepth = LinearizeDepth(pixelDepth, 1.0f, 100.0f);
-                float linearCurPosZ = LinearizeDepth(curPosZ, 1.0f, 100.0f);
-                float linearPrevPosZ = LinearizeDepth(prevPosZ, 1.0f, 100.0f);
-
-                // Calculer la distance à la surface
-                float distanceToSurface = abs(linearCurPosZ - linearPixelDepth);
-
-                if (linearCurPosZ >= linearPixelDepth && distanceToSurface < 0.1f)
+                steps++;
+                const vec2 position = startPixel + delta * t;
+                const int levelWidth = (GetWidth() + (1 << level) - 1) >> level;
+                const int cellX = std::min(static_cast<int>(position.x), GetWidth() - 1) >> level;
+                const int cellY = std::min(static_cast<int>(position.y), GetHeight() - 1) >> level;
+
+                // Sortie de la cellule le long du rayon.
+                float tExit = tEnd;
+                if (delta.x > 0.0f)
+                    tExit = std::min(tExit, (static_cast<float>((cellX + 1) << level) - startPixel.x) / delta.x);
+                else if (delta.x < 0.0f)
+                    tExit = std::min(tExit, (static_cast<float>(cellX << level) - startPixel.x) / delta.x);
+                if (delta.y > 0.0f)
+                    tExit = std::min(tExit, (static_cast<float>((cellY + 1) << level) - startPixel.y) / delta.y);
+                else if (delta.y < 0.0f)
+                    tExit = std::min(tExit, (static_cast<float>(cellY << level) - startPixel.y) / delta.y);
+
+                const float depthIn = 1.0f / (invDepthStart + invDepthDelta * t);
+                const float depthOut = 1.0f / (invDepthStart + invDepthDelta * tExit);
+                const float rayNear = std::min(depthIn, depthOut);
+                const float rayFar = std::max(depthIn, depthOut);
+                const float surface = hiZ[level][cellY * levelWidth + cellX];
+
+                if (rayFar < surface)
+                {
+                    t = tExit + nudge;
+                    level = std::min(level + 1, topLevel);
+                    continue;
+                }
+                if (level > 0)
+                {
+                    level--;
+                    continue;
+                }
+                if (rayNear < surface + thickness)
                 {
                     hit = true;
-                    hitColor = GetPixelAlbedo(screenX, screenY);
+                    hitColor = GetPixelAlbedo(cellX, cellY);
                     break;
                 }
-
-                curPos += reflection * stepSize;
-                prevPosZ = curPosZ;
+                t = tExit + nudge;
             }
+            tracedRays++;
+            totalSteps += steps;
 
             // BLENDING - Mélanger couleur originale et réflexion selon Fresnel
             vec3 baseColor = GetPixelAlbedo(x, y); // Couleur originale du pixel
@@ -778,6 +1149,9 @@ void Device::ApplyScreenSpaceReflections(const std::shared_ptr<Camera> &camera,
         }
     }
 
+    if (tracedRays > 0)
+        std::cout << "SSR steps per ray : " << static_cast<double>(totalSteps) / tracedRays
+                  << " (" << tracedRays << " rays)" << std::endl;
     std::cout << "SSR completed." << std::endl;
 }
 
@@ -11,9 +11,12 @@
 
 #include <stdio.h>
 #include "../Tools/MatrixTools.h"
+#include "../Tools/SimdKernels.hpp"
 #include "Camera.hpp"
+#include "Frustum.hpp"
 #include "Light.hpp"
 #include "../LoadingFiles/Mesh.hpp"
+#include "../LoadingFiles/MeshStream.hpp"
 #include <algorithm>
 #include <vector>
 #include <mutex>
@@ -26,91 +29,63 @@ using namespace glm;
 
 namespace Render3D
 {
-    struct Plane {
-        vec3 normal;
-        float distance;
-        
-        // Calcule la distance signée d'un point au plan
-        float distanceToPoint(const vec3& point) const {
-            return normal.x * point.x + normal.y * point.y + normal.z * point.z + distance;
-        }
+    // Au-delà de ce nombre de pixels dans sa boîte englobante, un triangle passe par le parcours par lignes.
+    constexpr int SmallTriangleMaxSamples = 16;
+
+    // Données d'un triangle partagées par tous ses pixels (références : rien du maillage n'est copié).
+    struct TriangleShading
+    {
+        const Face& face;
+        const vector<vec3>& normals;
+        const vector<vec2>& uvs;
+        const mat3x3& normalMatrix;
+        const SetupTriangle& setup;
+        vec3 screen[3];
+        vec3 world[3];
+        Lights& light;
+        const std::shared_ptr<Camera>& camera;
+        Textures& tex;
+        TextureNormalMap& nTex;
+        TextureParallaxMapping& pTex;
     };
 
-    struct Frustum {
-        Plane planes[6]; // Left, Right, Bottom, Top, Near, Far
-        
-        // Extrait les 6 plans du frustum depuis la matrice proj*view
-        void extractFromMatrix(const mat4x4& projView) {
-            // Left plane
-            planes[0].normal.x = projView[0][3] + projView[0][0];
-            planes[0].normal.y = projView[1][3] + projView[1][0];
-            planes[0].normal.z = projView[2][3] + projView[2][0];
-            planes[0].distance = projView[3][3] + projView[3][0];
-            normalizePlane(planes[0]);
-            
-            // Right plane
-            planes[1].normal.x = projView[0][3] - projView[0][0];
-            planes[1].normal.y = projView[1][3] - projView[1][0];
-            planes[1].normal.z = projView[2][3] - projView[2][0];
-            planes[1].distance = projView[3][3] - projView[3][0];
-            normalizePlane(planes[1]);
-            
-            // Bottom plane
-            planes[2].normal.x = projView[0][3] + projView[0][1];
-            planes[2].normal.y = projView[1][3] + projView[1][1];
-            planes[2].normal.z = projView[2][3] + projView[2][1];
-            planes[2].distance = projView[3][3] + projView[3][1];
-            normalizePlane(planes[2]);
-            
-            // Top plane
-            planes[3].normal.x = projView[0][3] - projView[0][1];
-            planes[3].normal.y = projView[1][3] - projView[1][1];
-            planes[3].normal.z = projView[2][3] - projView[2][1];
-            planes[3].distance = projView[3][3] - projView[3][1];
-            normalizePlane(planes[3]);
-            
-            // Near plane
-            planes[4].normal.x = projView[0][3] + projView[0][2];
-            planes[4].normal.y = projView[1][3] + projView[1][2];
-            planes[4].normal.z = projView[2][3] + projView[2][2];
-            planes[4].distance = projView[3][3] + projView[3][2];
-            normalizePlane(planes[4]);
-            
-            // Far plane
-            planes[5].normal.x = projView[0][3] - projView[0][2];
-            planes[5].normal.y = projView[1][3] - projView[1][2];
-            planes[5].normal.z = projView[2][3] - projView[2][2];
-            planes[5].distance = projView[3][3] - projView[3][2];
-            normalizePlane(planes[5]);
-        }
-        
-        // Teste si un triangle est complètement hors du frustum
-        bool isTriangleOutside(const vec3& a, const vec3& b, const vec3& c) const {
-            // Pour chaque plan, si les 3 sommets sont du mauvais côté, le triangle est rejeté
-            for (int i = 0; i < 6; i++) {
-                if (planes[i].distanceToPoint(a) < -0.1f &&
-                    planes[i].distanceToPoint(b) < -0.1f &&
-                    planes[i].distanceToPoint(c) < -0.1f) {
-                    return true; // Triangle complètement hors du frustum
-                }
-            }
-            return false; // Au moins partiellement visible
-        }
-        
-    private:
-        void normalizePlane(Plane& plane) {
-            float length = sqrt(plane.normal.x * plane.normal.x + 
-                            plane.normal.y * plane.normal.y + 
-                            plane.normal.z * plane.normal.z);
-            if (length > 0.0f) {
-                plane.normal.x /= length;
-                plane.normal.y /= length;
-                plane.normal.z /= length;
-                plane.distance /= length;
-            }
+    // Lumières et textures d'un lot de faces de même matériau, construites une fois par lot.
+    struct MaterialShading
+    {
+        Lights light;
+        Textures tex;
+        TextureNormalMap nTex;
+        TextureParallaxMapping pTex;
+
+        // pixelsPerUv : empreinte du lot à l'écran, qui fixe la résolution de décodage des textures.
+        MaterialShading(const Lights& sceneLights, const ConstantLight& material, float pixelsPerUv = FullResolution)
+            : light(sceneLights), tex(material.pathTexture, pixelsPerUv), nTex(material.pathTextureBump, pixelsPerUv),
+              pTex(material.pathTextureDisp, 0.15f, pixelsPerUv)
+        {
+            light.setConstantLight(material);
         }
     };
 
+    // Centre de pixel couvert par un petit triangle, avec ses trois fonctions d'arête.
+    struct CoveredSample
+    {
+        int x;
+        int y;
+        float weight[3];
+    };
+
+    // Compteurs d'une image, cumulés sur tous les Mesh rendus.
+    struct RenderStats
+    {
+        int totalClusters = 0;
+        int culledClusters = 0;
+        size_t setupTriangles = 0;
+        size_t rasterizedTriangles = 0;
+        size_t clippedTriangles = 0;
+        size_t smallTriangles = 0;
+        size_t emptyTriangles = 0;
+    };
+
     class Device
     {
         private:
@@ -129,13 +104,19 @@ namespace Render3D
 
             //Display
             void SetPixelColor(int x, int y, float r, float g, float b);
-            void RasterizeTriangle(const mat4x4& proj, const mat4x4& world, const mat3x3& normalMatrix, Face f, Mesh mesh, Lights l, std::shared_ptr<Camera> camera, vector<dvec3> projected_coordinates, vector<vec3> world_coordinates, vector<float> Z_correction, Textures& tex, TextureNormalMap& nTex, TextureParallaxMapping& pTex);
+            void RasterizeTriangle(TriangleShading& t);
+            void ShadeSamples(const CoveredSample* samples, int count, TriangleShading& t);
+            void ShadePixel(int x, int y, float Weight_RED, float Weight_GREEN, float Weight_BLUE, TriangleShading& t);
 
             //Matrix
             float Projection_3D_to_2D(vec3& coordinate, const mat4x4& projection, vec3& out);
 
             //Picture
-            void RenderScene(std::shared_ptr<Camera> camera, Mesh meshes, Lights& l);
+            void BuildFrameMatrices(const std::shared_ptr<Camera>& camera, mat4x4& view, mat4x4& proj);
+            void RenderScene(std::shared_ptr<Camera> camera, Mesh& meshes, Lights& l);
+            void RenderStream(std::shared_ptr<Camera> camera, MeshStream& stream, Lights& l);
+            void RenderMesh(const std::shared_ptr<Camera>& camera, Mesh& meshes, Lights& l, const mat4x4& view, const mat4x4& proj, RenderStats& stats);
+            void FinishFrame(const std::shared_ptr<Camera>& camera, const mat4x4& view, const mat4x4& proj, const RenderStats& stats, double renderingTime);
             void ApplyScreenSpaceReflections(const std::shared_ptr<Camera>& camera,  const mat4x4& view , const mat4x4& proj);
 
             //getter
@@ -0,0 +1,139 @@
+/**
+ * @file Frustum.hpp
+ * @brief Plans du frustum de vue et tests de visibilité (triangles, sphères, boîtes).
+ */
+
+#ifndef Frustum_hpp
+#define Frustum_hpp
+
+#include <cmath>
+#include "../Tools/MatrixTools.h"
+
+using namespace glm;
+
+namespace Render3D
+{
+    struct Plane {
+        vec3 normal;
+        float distance;
+        
+        // Calcule la distance signée d'un point au plan
+        float distanceToPoint(const vec3& point) const {
+            return normal.x * point.x + normal.y * point.y + normal.z * point.z + distance;
+        }
+    };
+
+    struct Frustum {
+        static constexpr int AllPlanes = 0x3F;
+
+        Plane planes[6]; // Left, Right, Bottom, Top, Near, Far
+        
+        // Extrait les 6 plans du frustum depuis la matrice proj*view
+        void extractFromMatrix(const mat4x4& projView) {
+            // Left plane
+            planes[0].normal.x = projView[0][3] + projView[0][0];
+            planes[0].normal.y = projView[1][3] + projView[1][0];
+            planes[0].normal.z = projView[2][3] + projView[2][0];
+            planes[0].distance = projView[3][3] + projView[3][0];
+            normalizePlane(planes[0]);
+            
+            // Right plane
+            planes[1].normal.x = projView[0][3] - projView[0][0];
+            planes[1].normal.y = projView[1][3] - projView[1][0];
+            planes[1].normal.z = projView[2][3] - projView[2][0];
+            planes[1].distance = projView[3][3] - projView[3][0];
+            normalizePlane(planes[1]);
+            
+            // Bottom plane
+            planes[2].normal.x = projView[0][3] + projView[0][1];
+            planes[2].normal.y = projView[1][3] + projView[1][1];
+            planes[2].normal.z = projView[2][3] + projView[2][1];
+            planes[2].distance = projView[3][3] + projView[3][1];
+            normalizePlane(planes[2]);
+            
+            // Top plane
+            planes[3].normal.x = projView[0][3] - projView[0][1];
+            planes[3].normal.y = projView[1][3] - projView[1][1];
+            planes[3].normal.z = projView[2][3] - projView[2][1];
+            planes[3].distance = projView[3][3] - projView[3][1];
+            normalizePlane(planes[3]);
+            
+            // Near plane
+            planes[4].normal.x = projView[0][3] + projView[0][2];
+            planes[4].normal.y = projView[1][3] + projView[1][2];
+            planes[4].normal.z = projView[2][3] + projView[2][2];
+            planes[4].distance = projView[3][3] + projView[3][2];
+            normalizePlane(planes[4]);
+            
+            // Far plane
+            planes[5].normal.x = projView[0][3] - projView[0][2];
+            planes[5].normal.y = projView[1][3] - projView[1][2];
+            planes[5].normal.z = projView[2][3] - projView[2][2];
+            planes[5].distance = projView[3][3] - projView[3][2];
+            normalizePlane(planes[5]);
+        }
+        
+        // Teste si un triangle est complètement hors du frustum
+        bool isTriangleOutside(const vec3& a, const vec3& b, const vec3& c) const {
+            // Pour chaque plan, si les 3 sommets sont du mauvais côté, le triangle est rejeté
+            for (int i = 0; i < 6; i++) {
+                if (planes[i].distanceToPoint(a) < -0.1f &&
+                    planes[i].distanceToPoint(b) < -0.1f &&
+                    planes[i].distanceToPoint(c) < -0.1f) {
+                    return true; // Triangle complètement hors du frustum
+                }
+            }
+            return false; // Au moins partiellement visible
+        }
+
+        // Teste si une sphère englobante est complètement hors du frustum
+        bool isSphereOutside(const vec3& center, float radius) const {
+            for (int i = 0; i < 6; i++) {
+                if (planes[i].distanceToPoint(center) < -radius) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Classe une boîte englobante (AABB) contre les plans encore actifs de "mask".
+        // Retourne -1 si la boîte est hors du frustum, sinon le masque des plans
+        // qu'elle coupe encore (0 : entièrement à l'intérieur, les enfants n'ont
+        // plus besoin d'être testés).
+        int classifyAABB(const vec3& bbMin, const vec3& bbMax, int mask = AllPlanes) const {
+            vec3 center = (bbMin + bbMax) * 0.5f;
+            vec3 extent = (bbMax - bbMin) * 0.5f;
+            int outMask = 0;
+            for (int i = 0; i < 6; i++) {
+                if ((mask & (1 << i)) == 0) {
+                    continue;
+                }
+                float d = planes[i].distanceToPoint(center);
+                float r = extent.x * std::abs(planes[i].normal.x) +
+                          extent.y * std::abs(planes[i].normal.y) +
+                          extent.z * std::abs(planes[i].normal.z);
+                if (d < -r) {
+                    return -1; // Complètement du mauvais côté d'un plan
+                }
+                if (d < r) {
+                    outMask |= (1 << i); // La boîte chevauche ce plan
+                }
+            }
+            return outMask;
+        }
+        
+    private:
+        void normalizePlane(Plane& plane) {
+            float length = sqrt(plane.normal.x * plane.normal.x + 
+                            plane.normal.y * plane.normal.y + 
+                            plane.normal.z * plane.normal.z);
+            if (length > 0.0f) {
+                plane.normal.x /= length;
+                plane.normal.y /= length;
+                plane.normal.z /= length;
+                plane.distance /= length;
+            }
+        }
+    };
+};
+#endif /* Frustum_hpp */
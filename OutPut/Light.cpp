@@ -222,81 +222,48 @@ void Lights::ComputeSpecular(vec3 camera_position, float s, mat3x3 TBN, bool par
     }
 }
 
-vec3 Lights::getIntensity(vec3 weight, Face f)
+vec3 Lights::getIntensity(vec3 weight, const Face& f)
 {
     float ao = 0.7f; // f.A.occlusion * weight.x + f.B.occlusion * weight.y + f.C.occlusion * weight.z;
 
-    __m128 Ke_simd = vec3_to_m128(_constantLight.Ke);
-    __m128 Ka_simd = vec3_to_m128(_constantLight.Ka);
-    __m128 Kd_simd = vec3_to_m128(_constantLight.Kd);
-    __m128 Ks_simd = vec3_to_m128(_constantLight.Ks);
-
-    __m128 ao_simd = _mm_set1_ps(ao);
-
-    __m128 i_simd = _mm_fmadd_ps(Ka_simd, ao_simd, Ke_simd);
-
-    __m128 directLight_simd = _mm_setzero_ps();
-    __m128 pointLight_simd = _mm_setzero_ps();
-    __m128 spotLight_simd = _mm_setzero_ps();
+    MaterialTerms material = {
+        {_constantLight.Ka.x, _constantLight.Ka.y, _constantLight.Ka.z, 0.0f},
+        {_constantLight.Kd.x, _constantLight.Kd.y, _constantLight.Kd.z, 0.0f},
+        {_constantLight.Ks.x, _constantLight.Ks.y, _constantLight.Ks.z, 0.0f},
+        {_constantLight.Ke.x, _constantLight.Ke.y, _constantLight.Ke.z, 0.0f}};
 
+    _samples.clear();
     for (std::map<string, Light>::iterator it = _mLights.begin(); it != _mLights.end(); ++it)
     {
-        if (it->second._typeOfLight == LightType::DirectionLight)
-        {
-            __m128 color_simd = vec3_to_m128(it->second._color);
-            __m128 dot_simd = _mm_set1_ps(it->second.dot);
-            __m128 spec_simd = _mm_set1_ps(it->second.spec);
+        const Light &light = it->second;
+        LightSample s = {{light._color.x, light._color.y, light._color.z, 0.0f}, light.dot, light.spec, 1.0f, 0};
 
-            __m128 DirectDot_simd = _mm_mul_ps(dot_simd, color_simd);
-            directLight_simd = _mm_fmadd_ps(Kd_simd, DirectDot_simd, directLight_simd);
+        if (light._typeOfLight == LightType::DirectionLight)
+        {
+            s.group = 0;
+        }
+        else if (light._typeOfLight == LightType::PointLight)
+        {
+            s.group = 1;
+            s.factor = light.attenuation;
+        }
+        else if (light._typeOfLight == LightType::SpotLight)
+        {
+            s.group = 2;
+            s.factor = light.spot;
         }
         else
         {
-            if (it->second._typeOfLight == LightType::PointLight)
-            {
-                __m128 color_simd = vec3_to_m128(it->second._color);
-                __m128 dot_simd = _mm_set1_ps(it->second.dot);
-                __m128 spec_simd = _mm_set1_ps(it->second.spec);
-                __m128 att_simd = _mm_set1_ps(it->second.attenuation);
-
-                __m128 PointDot_simd = _mm_mul_ps(dot_simd, color_simd);
-                __m128 PointSpec_simd = _mm_mul_ps(spec_simd, color_simd);
-
-                __m128 temp = _mm_mul_ps(Kd_simd, PointDot_simd);
-
-                temp = _mm_fmadd_ps(Ks_simd, PointSpec_simd, temp);
-
-                pointLight_simd = _mm_fmadd_ps(temp, att_simd, pointLight_simd);
-            }
-            else if (it->second._typeOfLight == LightType::SpotLight)
-            {
-                __m128 color_simd = vec3_to_m128(it->second._color);
-                __m128 dot_simd = _mm_set1_ps(it->second.dot);
-                __m128 spec_simd = _mm_set1_ps(it->second.spec);
-                __m128 spot_simd = _mm_set1_ps(it->second.spot);
-
-                __m128 SpotDot_simd = _mm_mul_ps(dot_simd, color_simd);
-                __m128 SpotSpec_simd = _mm_mul_ps(spec_simd, color_simd);
-
-                __m128 temp = _mm_mul_ps(Kd_simd, SpotDot_simd);
-
-                temp = _mm_fmadd_ps(Ks_simd, SpotSpec_simd, temp);
-
-                spotLight_simd = _mm_fmadd_ps(temp, spot_simd, spotLight_simd);
-            }
+            continue;
         }
+        _samples.push_back(s);
     }
 
-    i_simd = _mm_add_ps(i_simd, directLight_simd);
-    i_simd = _mm_add_ps(i_simd, pointLight_simd);
-    i_simd = _mm_add_ps(i_simd, spotLight_simd);
-
-    // Clamping [0, 1]
-    __m128 zero = _mm_setzero_ps();
-    __m128 one = _mm_set1_ps(1.0f);
-    i_simd = clamp_m128(i_simd, zero, one);
+    // Noyau SSE4.2 / FMA choisi au démarrage selon le processeur.
+    float intensity[4];
+    GetSimdKernels().shadeLights(material, ao, _samples.data(), _samples.size(), intensity);
 
-    return m128_to_vec3(i_simd);
+    return vec3(intensity[0], intensity[1], intensity[2]);
 }
 
 vec3 Lights::getPosition(string name)
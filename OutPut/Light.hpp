@@ -14,6 +14,7 @@
 #include <vector>
 #include <map>
 #include "../LoadingFiles/Mesh.hpp"
+#include "../Tools/SimdKernels.hpp"
 #include <iostream>
 #include <immintrin.h>
 using namespace glm;
@@ -74,6 +75,7 @@ namespace Render3D
         ConstantLight _constantLight;
         vec3 point3D_position{0.0f};
         vec3 N{0.0f};
+        vector<LightSample> _samples; // Lumières actives remises à plat pour le noyau ShadeLights
 
     public:
         Lights();
@@ -84,7 +86,7 @@ namespace Render3D
         void ComputeSpecular(vec3 camera_position, float s, mat3x3 TBN = {}, bool parallax = false);
         void ComputeAttenuation(string name, float C1 = 0.0f, float C2 = 0.0f, float radius = 0.0f);
         void ComputeSpotLight(string name, float cutoff, float outerCutoff);
-        vec3 getIntensity(vec3 weight, Face f);
+        vec3 getIntensity(vec3 weight, const Face& f);
         vec3 getPosition(string name);
         vec3 getConstantKd();
         string getPathTexture() const;
@@ -0,0 +1,176 @@
+/**
+ * @file SceneBVH.cpp
+ * @brief Construction, refit et parcours du BVH de la scène.
+ */
+
+#include "SceneBVH.hpp"
+#include <algorithm>
+
+using namespace Render3D;
+
+void SceneBVH::build(vector<BVHLeaf> leaves, const vector<mat4x4>& worldMatrices)
+{
+    _leaves = std::move(leaves);
+    _nodes.clear();
+
+    if (_leaves.empty())
+        return;
+
+    for (BVHLeaf& leaf : _leaves)
+        computeWorldBounds(leaf, worldMatrices[leaf.object]);
+
+    _nodes.reserve(2 * _leaves.size() / MaxLeavesPerNode + 1);
+    buildNode(0, static_cast<int>(_leaves.size()));
+}
+
+int SceneBVH::buildNode(int firstLeaf, int leafCount)
+{
+    int index = static_cast<int>(_nodes.size());
+    _nodes.push_back(BVHNode());
+
+    BVHNode node;
+    node.firstLeaf = firstLeaf;
+    node.leafCount = leafCount;
+    node.bbMin = _leaves[firstLeaf].worldMin;
+    node.bbMax = _leaves[firstLeaf].worldMax;
+
+    vec3 centroidMin = (_leaves[firstLeaf].worldMin + _leaves[firstLeaf].worldMax) * 0.5f;
+    vec3 centroidMax = centroidMin;
+
+    for (int k = firstLeaf; k < firstLeaf + leafCount; k++)
+    {
+        node.bbMin = min(node.bbMin, _leaves[k].worldMin);
+        node.bbMax = max(node.bbMax, _leaves[k].worldMax);
+        vec3 centroid = (_leaves[k].worldMin + _leaves[k].worldMax) * 0.5f;
+        centroidMin = min(centroidMin, centroid);
+        centroidMax = max(centroidMax, centroid);
+    }
+
+    if (leafCount > MaxLeavesPerNode)
+    {
+        // Découpe médiane sur l'axe où les centres sont le plus étalés.
+        vec3 spread = centroidMax - centroidMin;
+        int axis = 0;
+        if (spread.y > spread[axis]) axis = 1;
+        if (spread.z > spread[axis]) axis = 2;
+
+        int half = leafCount / 2;
+        std::nth_element(_leaves.begin() + firstLeaf, _leaves.begin() + firstLeaf + half,
+                         _leaves.begin() + firstLeaf + leafCount,
+                         [axis](const BVHLeaf& a, const BVHLeaf& b)
+                         {
+                             return (a.worldMin[axis] + a.worldMax[axis]) < (b.worldMin[axis] + b.worldMax[axis]);
+                         });
+
+        node.left = buildNode(firstLeaf, half);
+        node.right = buildNode(firstLeaf + half, leafCount - half);
+    }
+
+    _nodes[index] = node;
+    return index;
+}
+
+void SceneBVH::refit(const vector<mat4x4>& worldMatrices)
+{
+    for (BVHLeaf& leaf : _leaves)
+        computeWorldBounds(leaf, worldMatrices[leaf.object]);
+
+    // Les enfants sont toujours créés après leur parent :
+    // un parcours à rebours met à jour les feuilles avant les noeuds internes.
+    for (int n = static_cast<int>(_nodes.size()) - 1; n >= 0; n--)
+    {
+        BVHNode& node = _nodes[n];
+        if (node.left < 0)
+        {
+            node.bbMin = _leaves[node.firstLeaf].worldMin;
+            node.bbMax = _leaves[node.firstLeaf].worldMax;
+            for (int k = node.firstLeaf; k < node.firstLeaf + node.leafCount; k++)
+            {
+                node.bbMin = min(node.bbMin, _leaves[k].worldMin);
+                node.bbMax = max(node.bbMax, _leaves[k].worldMax);
+            }
+        }
+        else
+        {
+            node.bbMin = min(_nodes[node.left].bbMin, _nodes[node.right].bbMin);
+            node.bbMax = max(_nodes[node.left].bbMax, _nodes[node.right].bbMax);
+        }
+    }
+}
+
+void SceneBVH::collectVisible(const Frustum& frustum, vector<vector<int>>& visible) const
+{
+    if (_nodes.empty())
+        return;
+
+    struct StackEntry
+    {
+        int node;
+        int mask;
+    };
+
+    vector<StackEntry> stack;
+    stack.push_back({0, Frustum::AllPlanes});
+
+    while (!stack.empty())
+    {
+        StackEntry entry = stack.back();
+        stack.pop_back();
+        const BVHNode& node = _nodes[entry.node];
+
+        int mask = entry.mask;
+        if (mask != 0)
+        {
+            mask = frustum.classifyAABB(node.bbMin, node.bbMax, mask);
+            if (mask < 0)
+                continue; // Sous-arbre entièrement hors du frustum
+        }
+
+        if (node.left >= 0)
+        {
+            stack.push_back({node.right, mask});
+            stack.push_back({node.left, mask});
+            continue;
+        }
+
+        for (int k = node.firstLeaf; k < node.firstLeaf + node.leafCount; k++)
+        {
+            const BVHLeaf& leaf = _leaves[k];
+            if (mask != 0 && frustum.classifyAABB(leaf.worldMin, leaf.worldMax, mask) < 0)
+                continue;
+            visible[leaf.object].push_back(leaf.meshlet);
+        }
+    }
+
+    for (vector<int>& meshlets : visible)
+        std::sort(meshlets.begin(), meshlets.end());
+}
+
+bool SceneBVH::empty() const
+{
+    return _nodes.empty();
+}
+
+int SceneBVH::get_leafCount() const
+{
+    return static_cast<int>(_leaves.size());
+}
+
+void SceneBVH::computeWorldBounds(BVHLeaf& leaf, const mat4x4& world) const
+{
+    // Transformation d'une AABB par le centre et la demi-étendue (Arvo).
+    vec3 center = (leaf.localMin + leaf.localMax) * 0.5f;
+    vec3 extent = (leaf.localMax - leaf.localMin) * 0.5f;
+
+    vec3 worldCenter = vec3(world * vec4(center, 1.0f));
+    vec3 worldExtent;
+    for (int r = 0; r < 3; r++)
+    {
+        worldExtent[r] = std::abs(world[0][r]) * extent.x +
+                         std::abs(world[1][r]) * extent.y +
+                         std::abs(world[2][r]) * extent.z;
+    }
+
+    leaf.worldMin = worldCenter - worldExtent;
+    leaf.worldMax = worldCenter + worldExtent;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file SceneBVH.hpp
+ * @brief Hiérarchie de volumes englobants (BVH) sur les objets et les meshlets de la scène.
+ */
+
+#ifndef SceneBVH_hpp
+#define SceneBVH_hpp
+
+#include <vector>
+#include "Frustum.hpp"
+
+using namespace std;
+using namespace glm;
+
+namespace Render3D
+{
+    /**
+     * @struct BVHLeaf
+     * @brief Feuille du BVH : un meshlet d'un objet
+     *
+     * La boîte en espace objet est fixée à la construction ; la boîte en
+     * espace monde est recalculée à chaque refit à partir de la matrice
+     * monde de l'objet.
+     */
+    struct BVHLeaf
+    {
+        int object = 0;
+        int meshlet = 0;
+        vec3 localMin = {0.0f, 0.0f, 0.0f};
+        vec3 localMax = {0.0f, 0.0f, 0.0f};
+        vec3 worldMin = {0.0f, 0.0f, 0.0f};
+        vec3 worldMax = {0.0f, 0.0f, 0.0f};
+    };
+
+    /**
+     * @struct BVHNode
+     * @brief Noeud du BVH (boîte en espace monde)
+     *
+     * Un noeud interne a deux enfants ; une feuille (left == -1) référence
+     * une plage [firstLeaf, firstLeaf + leafCount) du tableau des feuilles.
+     */
+    struct BVHNode
+    {
+        vec3 bbMin = {0.0f, 0.0f, 0.0f};
+        vec3 bbMax = {0.0f, 0.0f, 0.0f};
+        int left = -1;
+        int right = -1;
+        int firstLeaf = 0;
+        int leafCount = 0;
+    };
+
+    /**
+     * @class SceneBVH
+     * @brief BVH construit une fois au chargement puis réajusté (refit) quand les objets bougent
+     *
+     * Le parcours teste les boîtes contre les plans du frustum en propageant
+     * un masque de plans : un sous-arbre entièrement à l'intérieur d'un plan
+     * n'est plus testé contre lui, et un sous-arbre entièrement visible est
+     * accepté sans aucun test. Le coût dépend donc de ce qui est visible.
+     */
+    class SceneBVH
+    {
+        private:
+            static constexpr int MaxLeavesPerNode = 4;
+
+            vector<BVHNode> _nodes;
+            vector<BVHLeaf> _leaves;
+
+        public:
+            /**
+             * @brief Construit l'arbre (découpe médiane sur l'axe le plus long)
+             * @param leaves Meshlets de toute la scène avec leur boîte en espace objet
+             * @param worldMatrices Matrice monde de chaque objet
+             */
+            void build(vector<BVHLeaf> leaves, const vector<mat4x4>& worldMatrices);
+
+            /**
+             * @brief Recalcule les boîtes monde des feuilles puis des noeuds, sans changer la topologie
+             * @param worldMatrices Matrice monde de chaque objet
+             */
+            void refit(const vector<mat4x4>& worldMatrices);
+
+            /**
+             * @brief Collecte les meshlets dont la boîte intersecte le frustum
+             * @param frustum Frustum en espace monde (extrait de proj * view)
+             * @param visible Pour chaque objet, indices des meshlets visibles (triés)
+             */
+            void collectVisible(const Frustum& frustum, vector<vector<int>>& visible) const;
+
+            bool empty() const;
+            int get_leafCount() const;
+
+        private:
+            int buildNode(int firstLeaf, int leafCount);
+            void computeWorldBounds(BVHLeaf& leaf, const mat4x4& world) const;
+    };
+};
+#endif /* SceneBVH_hpp */
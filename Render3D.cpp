@@ -4,6 +4,10 @@
 #include "OutPut/Light.hpp"
 #include "OutPut/Device.hpp"
 #include "LoadingFiles/LoadObj.hpp"
+#include "LoadingFiles/MeshCache.hpp"
+#include "LoadingFiles/MeshStream.hpp"
+#include "Tools/SimdKernels.hpp"
+#include "Tools/MemoryUsage.hpp"
 #include <memory>
 #include <thread>
 #include <regex>
@@ -169,18 +173,46 @@ int main(int argc, char *argv[])
         // Creating Device.
         std::unique_ptr<Device> d = std::make_unique<Device>(1000, 563);
 
-        // Loading Objects.
-        std::unique_ptr<LoadObj> obj = std::make_unique<LoadObj>(string(argv[1]));
-        obj->get_Mesh(m);
-        obj.reset();
-
         camera->set_target(0.0f, 0.0f, 0.0f);
 
+        // Meshes larger than memory: chunks are paged in per frame from the on-disk geometry stream.
+        if (UseMeshStream(string(argv[1])))
+        {
+            auto loadStart = std::chrono::high_resolution_clock::now();
+            MeshStream stream(StreamBudgetBytes());
+            if (!stream.open(string(argv[1])) && (!LoadObj::buildStream(string(argv[1])) || !stream.open(string(argv[1]))))
+            {
+                throw std::runtime_error("Error: cannot build the geometry stream of the .obj file.");
+            }
+            std::chrono::duration<double> loadTime = std::chrono::high_resolution_clock::now() - loadStart;
+            cout << "Loading time : " << loadTime.count() << " s (geometry stream, " << stream.get_chunkCount() << " chunks)" << endl;
+            cout << "SIMD kernels: " << SimdLevelName(GetSimdKernels().level) << endl;
+
+            d->RenderStream(camera, stream, l);
+            cout << "Peak memory after rendering : " << PeakResidentBytes() / (1024 * 1024) << " MB" << endl;
+            return 0;
+        }
+
+        // Loading Objects (from the binary cache when it is up to date).
+        auto loadStart = std::chrono::high_resolution_clock::now();
+        bool fromCache = LoadMeshCache(string(argv[1]), m);
+        if (!fromCache)
+        {
+            std::unique_ptr<LoadObj> obj = std::make_unique<LoadObj>(string(argv[1]));
+            obj->get_Mesh(m);
+            SaveMeshCache(string(argv[1]), obj->get_nameMtl(), m);
+            obj.reset();
+        }
+        std::chrono::duration<double> loadTime = std::chrono::high_resolution_clock::now() - loadStart;
+        cout << "Loading time : " << loadTime.count() << " s" << (fromCache ? " (mesh cache)" : "") << endl;
+        cout << "Peak memory after loading : " << PeakResidentBytes() / (1024 * 1024) << " MB (mesh : "
+             << m.get_memoryUsage() / (1024 * 1024) << " MB)" << endl;
+
         // Application of Transformation on Objects.
         // m.set_rotation(0,0.0f, glm::radians(45.0f), 0.0f);
         //  m.set_position(0,0.0f,0.0f,3.0f);
 
-        for (MeshData me : m.get_meshData())
+        for (const MeshData& me : m.get_meshData())
         {
             cout << "Name of Mesh: " << me.nameMesh << '\n'
                  << endl;
@@ -188,6 +220,7 @@ int main(int argc, char *argv[])
 
         int const nbThreads = std::thread::hardware_concurrency();
         cout << "threads available:" << nbThreads << endl;
+        cout << "SIMD kernels: " << SimdLevelName(GetSimdKernels().level) << endl;
 
         /*Rendering*/
         d->RenderScene(camera, m, l);
@@ -0,0 +1,167 @@
+/**
+ * @file ObjChunkCheck.cpp
+ * @brief Vérifie que le parsing d'un OBJ par blocs donne le même Mesh qu'un parsing en un seul bloc.
+ *
+ * Chaque OBJ (par défaut tous les .obj des dossiers de Exemples, plus un OBJ généré avec des indices
+ * relatifs, des fins de ligne CRLF, plusieurs objets et matériaux) est chargé deux fois par LoadObj :
+ * en un seul bloc, puis découpé en tout petits blocs (R3D_OBJ_CHUNK_BYTES) pour que presque chaque
+ * ligne tombe dans un bloc différent. Sommets, uv, normales, objets, faces et matériaux doivent
+ * être identiques.
+ *
+ * Programme autonome, à lancer depuis la racine du dépôt (les chemins mtllib en dépendent) :
+ *   g++ -std=c++17 -O2 Tests/ObjChunkCheck.cpp $(ls LoadingFiles/[A-Z]*.cpp Tools/[A-Z]*.cpp OutPut/[A-Z]*.cpp) -ljpeg -lpthread -o objchunkcheck
+ *   ./objchunkcheck [fichier.obj ...]
+ * Code de sortie 0 si tous les fichiers concordent, 1 sinon.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../LoadingFiles/LoadObj.hpp"
+
+using namespace std;
+using namespace Render3D;
+
+namespace
+{
+    // Taille de bloc assez petite pour couper à chaque ligne, assez grande pour ne jamais en couvrir zéro.
+    const char* TinyChunkBytes = "16";
+    const char* SingleChunkBytes = "18446744073709551615";
+
+    void Load(const string& path, const char* chunkBytes, Mesh& mesh)
+    {
+        setenv("R3D_OBJ_CHUNK_BYTES", chunkBytes, 1);
+        LoadObj obj(path);
+        obj.get_Mesh(mesh);
+    }
+
+    // OBJ qui couvre ce que les exemples n'ont pas : indices négatifs, CRLF, 'o' et 'usemtl' répétés.
+    string WriteSyntheticObj()
+    {
+        const string path = (filesystem::temp_directory_path() / "r3d-objchunkcheck.obj").string();
+        ofstream out(path, ios::binary);
+        for (int o = 0; o < 40; o++)
+        {
+            out << "o Part" << o << "\r\n";
+            for (int k = 0; k < 4; k++)
+            {
+                out << "v " << o + (k & 1) << " " << (k >> 1) << " " << -0.5f * o << "\r\n";
+                out << "vt " << (k & 1) << " " << (k >> 1) << "\r\n";
+                out << "vn 0 0 " << (o % 2 == 0 ? 1 : -1) << "\r\n";
+            }
+            out << "usemtl Mat" << o % 3 << "\r\n";
+            out << "f -4/-4/-4 -3/-3/-3 -2/-2/-2\r\n";
+            if (o % 4 == 0)
+                out << "usemtl Mat" << (o + 1) % 3 << "\r\n";
+            out << "f -3/-3/-3 -1/-1/-1 -2/-2/-2\r\n";
+            out << "f " << 4 * o + 1 << "/" << 4 * o + 1 << "/" << 4 * o + 1 << " -1/-1/-1 -3/-3/-3\r\n";
+        }
+        return path;
+    }
+
+    template<typename T>
+    bool SameArray(const vector<T>& a, const vector<T>& b)
+    {
+        return a.size() == b.size() && equal(a.begin(), a.end(), b.begin());
+    }
+
+    bool SameFace(const Face& a, const Face& b)
+    {
+        return a.A.IndiceVertices == b.A.IndiceVertices && a.B.IndiceVertices == b.B.IndiceVertices
+            && a.C.IndiceVertices == b.C.IndiceVertices;
+    }
+
+    bool SameMaterial(const MaterialProperty& a, const MaterialProperty& b)
+    {
+        return a.useMtl == b.useMtl && a.pathTexture == b.pathTexture && a.pathTextureBump == b.pathTextureBump
+            && a.pathTextureDisp == b.pathTextureDisp && a.ns == b.ns && a.ka == b.ka && a.kd == b.kd
+            && a.ks == b.ks && a.ke == b.ke;
+    }
+
+    // Première différence entre les deux Mesh, ou chaîne vide.
+    string Compare(Mesh& single, Mesh& chunked)
+    {
+        const Vec3SoA& va = single.get_vertices_soa();
+        const Vec3SoA& vb = chunked.get_vertices_soa();
+        if (!SameArray(va.x, vb.x) || !SameArray(va.y, vb.y) || !SameArray(va.z, vb.z))
+            return "vertices";
+        if (!SameArray(single.get_uvs(), chunked.get_uvs()))
+            return "uvs";
+        if (!SameArray(single.get_normals(), chunked.get_normals()))
+            return "normals";
+
+        const vector<MeshData>& a = single.get_meshData();
+        const vector<MeshData>& b = chunked.get_meshData();
+        if (a.size() != b.size())
+            return "object count";
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            const string object = "object " + a[i].nameMesh + ": ";
+            if (a[i].nameMesh != b[i].nameMesh)
+                return object + "name";
+            if (a[i].firstVertex != b[i].firstVertex || a[i].vertexCount != b[i].vertexCount)
+                return object + "vertex range";
+            if (a[i].faces.size() != b[i].faces.size())
+                return object + "face count";
+            for (size_t f = 0; f < a[i].faces.size(); f++)
+                if (!SameFace(a[i].faces[f], b[i].faces[f]))
+                    return object + "face " + to_string(f);
+            if (!SameArray(a[i].faceMaterial, b[i].faceMaterial))
+                return object + "face materials";
+            if (a[i].material.size() != b[i].material.size())
+                return object + "material count";
+            for (size_t m = 0; m < a[i].material.size(); m++)
+                if (!SameMaterial(a[i].material[m], b[i].material[m]))
+                    return object + "material " + a[i].material[m].useMtl;
+        }
+        return "";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> paths(argv + 1, argv + argc);
+    string synthetic;
+    if (paths.empty())
+    {
+        for (const auto& dir : filesystem::directory_iterator("Exemples"))
+            if (dir.is_directory())
+                for (const auto& file : filesystem::directory_iterator(dir.path()))
+                    if (file.path().extension() == ".obj")
+                        paths.push_back(file.path().string());
+        sort(paths.begin(), paths.end());
+        synthetic = WriteSyntheticObj();
+        paths.push_back(synthetic);
+    }
+    if (paths.empty())
+    {
+        cerr << "No OBJ file to check" << endl;
+        return EXIT_FAILURE;
+    }
+
+    int failures = 0;
+    for (const string& path : paths)
+    {
+        Mesh single, chunked;
+        Load(path, SingleChunkBytes, single);
+        Load(path, TinyChunkBytes, chunked);
+        const string difference = Compare(single, chunked);
+        if (difference.empty())
+        {
+            cout << "OK   " << path << " (" << single.get_vertices_soa().size() << " vertices, "
+                 << single.get_meshData().size() << " objects)" << endl;
+        }
+        else
+        {
+            cout << "FAIL " << path << " : " << difference << endl;
+            failures++;
+        }
+    }
+    if (!synthetic.empty())
+        filesystem::remove(synthetic);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,175 @@
+#include "BlockCompression.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Texels d'un bloc 4x4 ; sur les bords d'une image dont la taille n'est pas multiple de 4,
+    // la dernière ligne / colonne est répétée.
+    void GatherBlock(const unsigned char* rgb, int width, int height, int bx, int by, float texels[16][3])
+    {
+        for (int j = 0; j < BlockSize; j++)
+            for (int i = 0; i < BlockSize; i++)
+            {
+                const int x = std::min(bx * BlockSize + i, width - 1);
+                const int y = std::min(by * BlockSize + j, height - 1);
+                const unsigned char* p = rgb + (static_cast<size_t>(y) * width + x) * 3;
+                for (int c = 0; c < 3; c++)
+                    texels[j * BlockSize + i][c] = p[c];
+            }
+    }
+
+    uint16_t To565(const float c[3])
+    {
+        const int r = static_cast<int>(std::lround(std::clamp(c[0], 0.0f, 255.0f) * 31.0f / 255.0f));
+        const int g = static_cast<int>(std::lround(std::clamp(c[1], 0.0f, 255.0f) * 63.0f / 255.0f));
+        const int b = static_cast<int>(std::lround(std::clamp(c[2], 0.0f, 255.0f) * 31.0f / 255.0f));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void From565(uint16_t c, float out[3])
+    {
+        out[0] = static_cast<float>(((c >> 11) << 3) | (c >> 13));
+        out[1] = static_cast<float>((((c >> 5) & 63) << 2) | ((c >> 9) & 3));
+        out[2] = static_cast<float>(((c & 31) << 3) | ((c >> 2) & 7));
+    }
+
+    // Bloc BC1 : extrémités sur l'axe principal des couleurs du bloc, puis couleur la plus proche pour chaque texel.
+    void CompressBC1Block(const float texels[16][3], unsigned char* block)
+    {
+        float mean[3] = { 0.0f, 0.0f, 0.0f };
+        for (int t = 0; t < 16; t++)
+            for (int c = 0; c < 3; c++)
+                mean[c] += texels[t][c] / 16.0f;
+
+        float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; // rr, rg, rb, gg, gb, bb
+        for (int t = 0; t < 16; t++)
+        {
+            const float d[3] = { texels[t][0] - mean[0], texels[t][1] - mean[1], texels[t][2] - mean[2] };
+            cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+            cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+        }
+
+        // Axe principal par itérations de la puissance, à partir de la diagonale du cube RGB.
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int k = 0; k < 8; k++)
+        {
+            const float next[3] = {
+                cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2] };
+            const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < 3; c++)
+                axis[c] = next[c] / length;
+        }
+
+        float tMin = 0.0f, tMax = 0.0f;
+        for (int t = 0; t < 16; t++)
+        {
+            const float p = (texels[t][0] - mean[0]) * axis[0] + (texels[t][1] - mean[1]) * axis[1] + (texels[t][2] - mean[2]) * axis[2];
+            tMin = std::min(tMin, p);
+            tMax = std::max(tMax, p);
+        }
+        float e0[3], e1[3];
+        for (int c = 0; c < 3; c++)
+        {
+            e0[c] = mean[c] + axis[c] * tMax;
+            e1[c] = mean[c] + axis[c] * tMin;
+        }
+
+        uint16_t c0 = To565(e0), c1 = To565(e1);
+        if (c0 < c1)
+            std::swap(c0, c1);
+        uint32_t indices = 0;
+        if (c0 != c1)
+        {
+            float palette[4][3];
+            From565(c0, palette[0]);
+            From565(c1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+                palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+            }
+            for (int t = 0; t < 16; t++)
+            {
+                int best = 0;
+                float bestError = 0.0f;
+                for (int i = 0; i < 4; i++)
+                {
+                    const float dr = texels[t][0] - palette[i][0], dg = texels[t][1] - palette[i][1], db = texels[t][2] - palette[i][2];
+                    const float error = dr * dr + dg * dg + db * db;
+                    if (i == 0 || error < bestError)
+                    {
+                        best = i;
+                        bestError = error;
+                    }
+                }
+                indices |= static_cast<uint32_t>(best) << (2 * t);
+            }
+        }
+        memcpy(block, &c0, 2);
+        memcpy(block + 2, &c1, 2);
+        memcpy(block + 4, &indices, 4);
+    }
+
+    // Bloc BC4 d'un canal : extrémités au minimum et au maximum du bloc.
+    void CompressBC4Block(const float texels[16][3], int channel, unsigned char* block)
+    {
+        int v0 = 0, v1 = 255;
+        for (int t = 0; t < 16; t++)
+        {
+            v0 = std::max(v0, static_cast<int>(texels[t][channel]));
+            v1 = std::min(v1, static_cast<int>(texels[t][channel]));
+        }
+        uint64_t bits = 0;
+        if (v0 != v1)
+        {
+            int palette[8] = { v0, v1 };
+            for (int i = 2; i < 8; i++)
+                palette[i] = ((8 - i) * v0 + (i - 1) * v1) / 7;
+            for (int t = 0; t < 16; t++)
+            {
+                int best = 0;
+                for (int i = 1; i < 8; i++)
+                    if (std::abs(static_cast<int>(texels[t][channel]) - palette[i]) < std::abs(static_cast<int>(texels[t][channel]) - palette[best]))
+                        best = i;
+                bits |= static_cast<uint64_t>(best) << (3 * t);
+            }
+        }
+        block[0] = static_cast<unsigned char>(v0);
+        block[1] = static_cast<unsigned char>(v1);
+        memcpy(block + 2, &bits, 6);
+    }
+}
+
+std::unique_ptr<unsigned char[]> CompressBC1(const unsigned char* rgb, int width, int height)
+{
+    std::unique_ptr<unsigned char[]> blocks(new unsigned char[BC1Size(width, height)]);
+    float texels[16][3];
+    unsigned char* out = blocks.get();
+    for (int by = 0; by < BlocksPerRow(height); by++)
+        for (int bx = 0; bx < BlocksPerRow(width); bx++, out += BC1BlockBytes)
+        {
+            GatherBlock(rgb, width, height, bx, by, texels);
+            CompressBC1Block(texels, out);
+        }
+    return blocks;
+}
+
+std::unique_ptr<unsigned char[]> CompressBC5(const unsigned char* rgb, int width, int height)
+{
+    std::unique_ptr<unsigned char[]> blocks(new unsigned char[BC5Size(width, height)]);
+    float texels[16][3];
+    unsigned char* out = blocks.get();
+    for (int by = 0; by < BlocksPerRow(height); by++)
+        for (int bx = 0; bx < BlocksPerRow(width); bx++, out += BC5BlockBytes)
+        {
+            GatherBlock(rgb, width, height, bx, by, texels);
+            CompressBC4Block(texels, 0, out);
+            CompressBC4Block(texels, 1, out + 8);
+        }
+    return blocks;
+}
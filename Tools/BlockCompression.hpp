@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Compression par blocs de 4x4 texels, au format des textures BC1 et BC5 des GPU.
+// BC1 : 8 octets par bloc (deux couleurs 565 et 16 indices de 2 bits), soit 0,5 octet par texel au lieu de 3.
+// BC5 : 16 octets par bloc, deux canaux (x et y d'une normale) codés chacun comme un bloc BC4
+// (deux valeurs 8 bits et 16 indices de 3 bits), soit 1 octet par texel ; z est reconstruit à la lecture.
+// Les blocs sont rangés ligne par ligne, dans le même ordre que les texels de l'image source.
+
+constexpr int BlockSize = 4;
+constexpr size_t BC1BlockBytes = 8;
+constexpr size_t BC5BlockBytes = 16;
+
+inline int BlocksPerRow(int width) { return (width + BlockSize - 1) / BlockSize; }
+inline size_t BC1Size(int width, int height) { return static_cast<size_t>(BlocksPerRow(width)) * BlocksPerRow(height) * BC1BlockBytes; }
+inline size_t BC5Size(int width, int height) { return static_cast<size_t>(BlocksPerRow(width)) * BlocksPerRow(height) * BC5BlockBytes; }
+
+// Compresse une image RGB 8 bits (width * height texels, 3 octets par texel).
+std::unique_ptr<unsigned char[]> CompressBC1(const unsigned char* rgb, int width, int height);
+
+// Compresse les canaux rouge et vert d'une image RGB 8 bits (normal map : x et y de la normale).
+std::unique_ptr<unsigned char[]> CompressBC5(const unsigned char* rgb, int width, int height);
+
+// Couleur RGB 8 bits du texel (x, y) d'une image BC1.
+inline void DecodeBC1Texel(const unsigned char* blocks, int width, int x, int y, unsigned char rgb[3])
+{
+    const unsigned char* block = blocks + (static_cast<size_t>(y / BlockSize) * BlocksPerRow(width) + x / BlockSize) * BC1BlockBytes;
+    uint16_t c0, c1;
+    uint32_t indices;
+    memcpy(&c0, block, 2);
+    memcpy(&c1, block + 2, 2);
+    memcpy(&indices, block + 4, 4);
+
+    const int index = (indices >> (2 * ((y % BlockSize) * BlockSize + x % BlockSize))) & 3;
+    const int r0 = ((c0 >> 11) << 3) | (c0 >> 13), g0 = (((c0 >> 5) & 63) << 2) | ((c0 >> 9) & 3), b0 = ((c0 & 31) << 3) | ((c0 >> 2) & 7);
+    const int r1 = ((c1 >> 11) << 3) | (c1 >> 13), g1 = (((c1 >> 5) & 63) << 2) | ((c1 >> 9) & 3), b1 = ((c1 & 31) << 3) | ((c1 >> 2) & 7);
+    // Le compresseur n'écrit que des blocs à 4 couleurs (c0 > c1, ou bloc uni) : couleurs 2 et 3 aux tiers.
+    static const int weight0[4] = { 3, 0, 2, 1 };
+    rgb[0] = static_cast<unsigned char>((r0 * weight0[index] + r1 * (3 - weight0[index])) / 3);
+    rgb[1] = static_cast<unsigned char>((g0 * weight0[index] + g1 * (3 - weight0[index])) / 3);
+    rgb[2] = static_cast<unsigned char>((b0 * weight0[index] + b1 * (3 - weight0[index])) / 3);
+}
+
+// Valeur 8 bits du texel d'indice texel (0 à 15) dans un bloc BC4.
+inline unsigned char DecodeBC4Value(const unsigned char* block, int texel)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, block + 2, 6);
+    const int index = static_cast<int>((bits >> (3 * texel)) & 7);
+    const int v0 = block[0], v1 = block[1];
+    // Indices 0 et 1 : les extrémités ; 2 à 7 : six valeurs intermédiaires de v0 vers v1.
+    if (index < 2)
+        return static_cast<unsigned char>(index == 0 ? v0 : v1);
+    return static_cast<unsigned char>(((8 - index) * v0 + (index - 1) * v1) / 7);
+}
+
+// Canaux x et y (8 bits) du texel (x, y) d'une image BC5.
+inline void DecodeBC5Texel(const unsigned char* blocks, int width, int x, int y, unsigned char rg[2])
+{
+    const unsigned char* block = blocks + (static_cast<size_t>(y / BlockSize) * BlocksPerRow(width) + x / BlockSize) * BC5BlockBytes;
+    const int texel = (y % BlockSize) * BlockSize + x % BlockSize;
+    rg[0] = DecodeBC4Value(block, texel);
+    rg[1] = DecodeBC4Value(block + 8, texel);
+}
@@ -0,0 +1,84 @@
+#include "CpuFeatures.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define R3D_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef R3D_X86
+
+static void Cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++)
+        regs[i] = static_cast<unsigned int>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long ReadXCR0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+static CpuFeatures DetectCpuFeatures()
+{
+    CpuFeatures features;
+    unsigned int regs[4];
+
+    Cpuid(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return features;
+
+    Cpuid(1, 0, regs);
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    features.sse42 = (regs[2] & (1u << 20)) != 0;
+    bool cpuAvx = (regs[2] & (1u << 28)) != 0;
+    bool cpuFma = (regs[2] & (1u << 12)) != 0;
+
+    if (!osxsave)
+        return features;
+
+    // XCR0 : bits 1-2 = états XMM/YMM, bits 5-7 = états AVX-512 (opmask, ZMM).
+    unsigned long long xcr0 = ReadXCR0();
+    bool osAvx = (xcr0 & 0x6) == 0x6;
+    bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+    features.avx = cpuAvx && osAvx;
+    features.fma = cpuFma && osAvx;
+
+    if (maxLeaf >= 7)
+    {
+        Cpuid(7, 0, regs);
+        features.avx2 = features.avx && (regs[1] & (1u << 5)) != 0;
+        features.avx512f = osAvx512 && (regs[1] & (1u << 16)) != 0;
+    }
+
+    return features;
+}
+#endif // R3D_X86
+
+const CpuFeatures& GetCpuFeatures()
+{
+#ifdef R3D_X86
+    static const CpuFeatures features = DetectCpuFeatures();
+#else
+    static const CpuFeatures features;
+#endif
+    return features;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Jeux d'instructions SIMD disponibles sur le processeur ET activés par le système
+// (les registres YMM/ZMM doivent être sauvegardés par l'OS, vérifié via XGETBV).
+struct CpuFeatures
+{
+    bool sse42 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+};
+
+// Interroge CPUID une seule fois (au premier appel) et renvoie le résultat mis en cache.
+const CpuFeatures& GetCpuFeatures();
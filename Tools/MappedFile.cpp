@@ -0,0 +1,183 @@
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path, bool populate)
+{
+    open(path, populate);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        std::swap(_open, other._open);
+#ifdef _WIN32
+        std::swap(_file, other._file);
+        std::swap(_mapping, other._mapping);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, bool)
+{
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    _file = file;
+    _size = static_cast<size_t>(size.QuadPart);
+    _open = true;
+    if (_size == 0) // un fichier vide ne peut pas être projeté
+        return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        close();
+        return false;
+    }
+    _mapping = mapping;
+    _data = static_cast<const char*>(view);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(static_cast<HANDLE>(_mapping));
+    if (_file)
+        CloseHandle(static_cast<HANDLE>(_file));
+    _data = nullptr;
+    _mapping = nullptr;
+    _file = nullptr;
+    _size = 0;
+    _open = false;
+}
+
+void MappedFile::discard(size_t, size_t)
+{
+    // Les pages d'une vue de fichier en lecture seule sont libérées par le système au besoin.
+}
+
+void MappedFile::prefetch(const std::string&)
+{
+    // FILE_FLAG_SEQUENTIAL_SCAN à l'ouverture assure déjà la lecture anticipée.
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, bool populate)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    _size = static_cast<size_t>(st.st_size);
+    _open = true;
+    if (_size > 0) // un fichier vide ne peut pas être projeté
+    {
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (populate)
+            flags |= MAP_POPULATE;
+#endif
+        void* view = mmap(nullptr, _size, PROT_READ, flags, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(fd);
+            _size = 0;
+            _open = false;
+            return false;
+        }
+        madvise(view, _size, populate ? MADV_WILLNEED : MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(view);
+    }
+    // La projection reste valide après la fermeture du descripteur.
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data)
+        munmap(const_cast<char*>(_data), _size);
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+}
+
+void MappedFile::discard(size_t offset, size_t size)
+{
+    if (_data == nullptr || offset >= _size)
+        return;
+    // madvise attend une adresse alignée sur la page : la page partiellement couverte au début est conservée.
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t first = (offset + page - 1) / page * page;
+    const size_t last = std::min(offset + size, _size);
+    if (last > first)
+        madvise(const_cast<char*>(_data) + first, last - first, MADV_DONTNEED);
+}
+
+void MappedFile::prefetch(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+#ifdef POSIX_FADV_WILLNEED
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    ::close(fd);
+}
+
+#endif
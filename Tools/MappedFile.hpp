@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Fichier projeté en mémoire en lecture seule (mmap / MapViewOfFile).
+// Le contenu reste accessible tant que l'objet existe ; aucune copie n'est faite.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path, bool populate = false);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Renvoie false si le fichier ne peut pas être ouvert ou projeté.
+    // populate : toutes les pages sont lues dès la projection (MAP_POPULATE), pour un fichier lu en entier.
+    bool open(const std::string& path, bool populate = false);
+    void close();
+
+    // Rend au système les pages déjà lues de [offset, offset + size) : elles seront relues
+    // depuis le disque au prochain accès. Sans effet si la plate-forme ne le permet pas.
+    void discard(size_t offset, size_t size);
+
+    // Annonce la lecture prochaine d'un fichier entier : le système commence à le charger
+    // en arrière-plan (posix_fadvise WILLNEED), sans projection ni attente.
+    static void prefetch(const std::string& path);
+
+    bool is_open() const { return _open; }
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+    const char* begin() const { return _data; }
+    const char* end() const { return _data + _size; }
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+    bool _open = false;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
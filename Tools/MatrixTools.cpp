@@ -1,5 +1,6 @@
 #include "MatrixTools.h"
 #include <iostream>
+#include "SimdKernels.hpp"
 
 #define PI 3.14159f
 
@@ -231,3 +232,22 @@ void Scale(float multiplicateur, mat4x4& m)
     m[2][2] = multiplicateur;
   } 
 };
+
+
+void TransformPositionsSoA(const float* x, const float* y, const float* z, size_t count, const mat4x4& m,
+                           float* outX, float* outY, float* outZ, float* outW)
+{
+  GetSimdKernels().transformPositions(x, y, z, count, m, outX, outY, outZ, outW);
+}
+
+void TransformNormalsSoA(const float* x, const float* y, const float* z, size_t count, const mat3x3& m,
+                         float* outX, float* outY, float* outZ)
+{
+  GetSimdKernels().transformNormals(x, y, z, count, m, outX, outY, outZ);
+}
+
+void ProjectClipToViewportSoA(const float* clipX, const float* clipY, const float* clipZ, const float* clipW, size_t count,
+                              float width, float height, float* screenX, float* screenY, float* screenZ)
+{
+  GetSimdKernels().projectClipToViewport(clipX, clipY, clipZ, clipW, count, width, height, screenX, screenY, screenZ);
+}
@@ -1,7 +1,23 @@
+#pragma once
 #include <glm.hpp>
+#include <vector>
+#include <cstddef>
 
 using namespace glm;
 
+// Tableau de vec3 rangé en SoA (Structure of Arrays) pour les noyaux de transformation par lots.
+struct Vec3SoA
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+
+    void resize(size_t n) { x.resize(n); y.resize(n); z.resize(n); }
+    size_t size() const { return x.size(); }
+    vec3 get(size_t k) const { return vec3(x[k], y[k], z[k]); }
+    void set(size_t k, const vec3& v) { x[k] = v.x; y[k] = v.y; z[k] = v.z; }
+};
+
 void MatrixInitZero(mat4x4& m); 
 
 void IdentityMatrix(mat4x4& m);
@@ -33,3 +49,18 @@ void Rotation_Z_Roll(mat4x4& m, float angle);
 void Rotation_XYZ_PitchYawRoll(mat4x4& mP, mat4x4& mY, mat4x4& mR , mat4x4& m);
 
 void Scale(float multiplicateur, mat4x4& mat4x4);
+
+// ===== Transformations par lots (SoA, noyau SSE4.2 / AVX2+FMA / AVX-512 choisi au démarrage, cf. SimdKernels) =====
+
+// Transforme "count" positions par une matrice 4x4 : sortie en coordonnées clip (x, y, z, w), sans division.
+void TransformPositionsSoA(const float* x, const float* y, const float* z, size_t count, const mat4x4& m,
+                           float* outX, float* outY, float* outZ, float* outW);
+
+// Transforme "count" normales par une matrice 3x3 (même convention que TransformVectorByMatrix3x3).
+void TransformNormalsSoA(const float* x, const float* y, const float* z, size_t count, const mat3x3& m,
+                         float* outX, float* outY, float* outZ);
+
+// Division perspective et passage en coordonnées écran, comme Device::Projection_3D_to_2D.
+// Les sorties peuvent être les mêmes tableaux que les entrées.
+void ProjectClipToViewportSoA(const float* clipX, const float* clipY, const float* clipZ, const float* clipW, size_t count,
+                              float width, float height, float* screenX, float* screenY, float* screenZ);
@@ -0,0 +1,5 @@
+#pragma once
+#include <cstddef>
+
+// Pic de mémoire résidente (RSS) du processus depuis son lancement, en octets ; 0 si inconnu.
+size_t PeakResidentBytes();
@@ -0,0 +1,906 @@
+#include "SimdKernels.hpp"
+#include "CpuFeatures.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define R3D_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Les variantes SIMD sont compilées pour leur jeu d'instructions quel que soit le -march global :
+// un seul binaire tourne sur toutes les machines et choisit au démarrage.
+#if defined(__GNUC__) || defined(__clang__)
+#define R3D_TARGET(isa) __attribute__((target(isa)))
+#else
+#define R3D_TARGET(isa)
+#endif
+
+static int LowestBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static int HighestBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<int>(index);
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+// ===== Noyaux scalaires (référence, et traitement des restes) =====
+
+static void TransformPositions_Scalar(const float* x, const float* y, const float* z, size_t count, const mat4x4& m,
+                                      float* outX, float* outY, float* outZ, float* outW)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float vx = x[i], vy = y[i], vz = z[i];
+        outX[i] = vx * m[0][0] + vy * m[1][0] + vz * m[2][0] + m[3][0];
+        outY[i] = vx * m[0][1] + vy * m[1][1] + vz * m[2][1] + m[3][1];
+        outZ[i] = vx * m[0][2] + vy * m[1][2] + vz * m[2][2] + m[3][2];
+        outW[i] = vx * m[0][3] + vy * m[1][3] + vz * m[2][3] + m[3][3];
+    }
+}
+
+static void TransformNormals_Scalar(const float* x, const float* y, const float* z, size_t count, const mat3x3& m,
+                                    float* outX, float* outY, float* outZ)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float vx = x[i], vy = y[i], vz = z[i];
+        outX[i] = vx * m[0][0] + vy * m[1][0] + vz * m[2][0];
+        outY[i] = vx * m[0][1] + vy * m[1][1] + vz * m[2][1];
+        outZ[i] = vx * m[0][2] + vy * m[1][2] + vz * m[2][2];
+    }
+}
+
+static void ProjectClipToViewport_Scalar(const float* clipX, const float* clipY, const float* clipZ, const float* clipW, size_t count,
+                                         float width, float height, float* screenX, float* screenY, float* screenZ)
+{
+    const float halfWidth = width * 0.5f;
+    const float halfHeight = height * 0.5f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float invW = 1.0f / clipW[i];
+        float ndcX = clipX[i] * invW;
+        float ndcY = clipY[i] * invW;
+        screenZ[i] = clipZ[i] * invW;
+        screenX[i] = (ndcX + 1.0f) * halfWidth;
+        screenY[i] = (-ndcY + 1.0f) * halfHeight;
+    }
+}
+
+static void ShadeLights_Scalar(const MaterialTerms& material, float ao, const LightSample* lights, size_t count, float out[4])
+{
+    float accum[3][3] = {};
+
+    for (size_t l = 0; l < count; l++)
+    {
+        const LightSample& s = lights[l];
+        for (int c = 0; c < 3; c++)
+        {
+            float diffuse = material.kd[c] * (s.dot * s.color[c]);
+            if (s.group == 0)
+                accum[0][c] += diffuse;
+            else
+                accum[s.group][c] += (diffuse + material.ks[c] * (s.spec * s.color[c])) * s.factor;
+        }
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        float i = material.ka[c] * ao + material.ke[c];
+        i = i + accum[0][c] + accum[1][c] + accum[2][c];
+        out[c] = std::min(std::max(i, 0.0f), 1.0f);
+    }
+    out[3] = 0.0f;
+}
+
+static bool RasterSpan_Scalar(const float w[3], const float dw[3], int count, int* first, int* last)
+{
+    int f = -1;
+    int l = -1;
+
+    for (int k = 0; k < count; k++)
+    {
+        float fk = static_cast<float>(k);
+        if (w[0] + fk * dw[0] >= 0.0f && w[1] + fk * dw[1] >= 0.0f && w[2] + fk * dw[2] >= 0.0f)
+        {
+            if (f < 0)
+                f = k;
+            l = k;
+        }
+        else if (f >= 0)
+        {
+            // Le triangle est convexe : la couverture d'une ligne est un seul intervalle.
+            break;
+        }
+    }
+
+    if (f < 0)
+        return false;
+
+    *first = f;
+    *last = l;
+    return true;
+}
+
+static size_t TriangleSetup_Scalar(const TriangleSetupInput& in, size_t count, SetupTriangle* out, int* clipList, size_t* clipCount)
+{
+    const float maxX = in.width - 1.0f;
+    const float maxY = in.height - 1.0f;
+    const float guardMinX = (1.0f - in.guardBand) * in.width * 0.5f, guardMaxX = (1.0f + in.guardBand) * in.width * 0.5f;
+    const float guardMinY = (1.0f - in.guardBand) * in.height * 0.5f, guardMaxY = (1.0f + in.guardBand) * in.height * 0.5f;
+    size_t survivors = 0;
+    *clipCount = 0;
+
+    for (size_t t = 0; t < count; t++)
+    {
+        const int ia = static_cast<int>(in.indices[3 * t]);
+        const int ib = static_cast<int>(in.indices[3 * t + 1]);
+        const int ic = static_cast<int>(in.indices[3 * t + 2]);
+
+        // Les trois sommets sont du même côté extérieur d'un plan du frustum.
+        if (in.outcodes[ia] & in.outcodes[ib] & in.outcodes[ic])
+            continue;
+
+        // Un sommet derrière le plan near : la projection n'a pas de sens, il faut découper.
+        if ((in.outcodes[ia] | in.outcodes[ib] | in.outcodes[ic]) & in.clipMask)
+        {
+            clipList[(*clipCount)++] = static_cast<int>(t);
+            continue;
+        }
+
+        const float ax = in.screenX[ia], ay = in.screenY[ia];
+        const float bx = in.screenX[ib], by = in.screenY[ib];
+        const float cx = in.screenX[ic], cy = in.screenY[ic];
+
+        const float area = ((cx - ax) * (by - ay)) - ((cy - ay) * (bx - ax));
+        if (!(area > 0.0f))
+            continue;
+
+        const float xMin = std::min(ax, std::min(bx, cx));
+        const float xMax = std::max(ax, std::max(bx, cx));
+        const float yMin = std::min(ay, std::min(by, cy));
+        const float yMax = std::max(ay, std::max(by, cy));
+        if (xMin > maxX || xMax < 0.0f || yMin > maxY || yMax < 0.0f)
+            continue;
+
+        if (xMin < guardMinX || xMax > guardMaxX || yMin < guardMinY || yMax > guardMaxY)
+        {
+            clipList[(*clipCount)++] = static_cast<int>(t);
+            continue;
+        }
+
+        SetupTriangle& s = out[survivors++];
+        s.index = static_cast<int>(t);
+        s.area = area;
+        s.x0 = static_cast<int>(std::max(0.0f, xMin));
+        s.x1 = static_cast<int>(std::min(maxX, xMax));
+        s.y0 = static_cast<int>(std::max(0.0f, yMin));
+        s.y1 = static_cast<int>(std::min(maxY, yMax));
+        s.stepX[0] = cy - by;
+        s.stepX[1] = ay - cy;
+        s.stepX[2] = by - ay;
+        s.invW[0] = 1.0f / in.clipW[ia];
+        s.invW[1] = 1.0f / in.clipW[ib];
+        s.invW[2] = 1.0f / in.clipW[ic];
+        s.clipped = false;
+    }
+
+    return survivors;
+}
+
+static void LinearizeDepth_Scalar(const float* depth, size_t count, float near, float far, float* out)
+{
+    const float num = 2.0f * near * far;
+    const float sum = far + near;
+    const float diff = far - near;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float z = depth[i] * 2.0f - 1.0f;
+        out[i] = num / (sum - z * diff);
+    }
+}
+
+#ifdef R3D_X86
+
+// ===== SSE4.2 (4 voies, mul + add) =====
+
+R3D_TARGET("sse4.2")
+static void TransformPositions_SSE42(const float* x, const float* y, const float* z, size_t count, const mat4x4& m,
+                                     float* outX, float* outY, float* outZ, float* outW)
+{
+    size_t i = 0;
+    __m128 col[4][4];
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            col[c][r] = _mm_set1_ps(m[c][r]);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        float* outs[4] = {outX, outY, outZ, outW};
+
+        for (int r = 0; r < 4; r++)
+        {
+            __m128 v = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, col[0][r]), _mm_mul_ps(vy, col[1][r])),
+                                             _mm_mul_ps(vz, col[2][r])),
+                                  col[3][r]);
+            _mm_storeu_ps(outs[r] + i, v);
+        }
+    }
+
+    TransformPositions_Scalar(x + i, y + i, z + i, count - i, m, outX + i, outY + i, outZ + i, outW + i);
+}
+
+R3D_TARGET("sse4.2")
+static void TransformNormals_SSE42(const float* x, const float* y, const float* z, size_t count, const mat3x3& m,
+                                   float* outX, float* outY, float* outZ)
+{
+    size_t i = 0;
+    __m128 col[3][3];
+    for (int c = 0; c < 3; c++)
+        for (int r = 0; r < 3; r++)
+            col[c][r] = _mm_set1_ps(m[c][r]);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        float* outs[3] = {outX, outY, outZ};
+
+        for (int r = 0; r < 3; r++)
+        {
+            __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, col[0][r]), _mm_mul_ps(vy, col[1][r])), _mm_mul_ps(vz, col[2][r]));
+            _mm_storeu_ps(outs[r] + i, v);
+        }
+    }
+
+    TransformNormals_Scalar(x + i, y + i, z + i, count - i, m, outX + i, outY + i, outZ + i);
+}
+
+R3D_TARGET("sse4.2")
+static void ProjectClipToViewport_SSE42(const float* clipX, const float* clipY, const float* clipZ, const float* clipW, size_t count,
+                                        float width, float height, float* screenX, float* screenY, float* screenZ)
+{
+    size_t i = 0;
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 hw = _mm_set1_ps(width * 0.5f);
+    const __m128 hh = _mm_set1_ps(height * 0.5f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 invW = _mm_div_ps(one, _mm_loadu_ps(clipW + i));
+        __m128 ndcX = _mm_mul_ps(_mm_loadu_ps(clipX + i), invW);
+        __m128 ndcY = _mm_mul_ps(_mm_loadu_ps(clipY + i), invW);
+        __m128 ndcZ = _mm_mul_ps(_mm_loadu_ps(clipZ + i), invW);
+
+        _mm_storeu_ps(screenX + i, _mm_mul_ps(_mm_add_ps(ndcX, one), hw));
+        _mm_storeu_ps(screenY + i, _mm_mul_ps(_mm_sub_ps(one, ndcY), hh));
+        _mm_storeu_ps(screenZ + i, ndcZ);
+    }
+
+    ProjectClipToViewport_Scalar(clipX + i, clipY + i, clipZ + i, clipW + i, count - i, width, height,
+                                 screenX + i, screenY + i, screenZ + i);
+}
+
+R3D_TARGET("sse4.2")
+static void ShadeLights_SSE42(const MaterialTerms& material, float ao, const LightSample* lights, size_t count, float out[4])
+{
+    const __m128 ka = _mm_loadu_ps(material.ka);
+    const __m128 kd = _mm_loadu_ps(material.kd);
+    const __m128 ks = _mm_loadu_ps(material.ks);
+    const __m128 ke = _mm_loadu_ps(material.ke);
+
+    __m128 i_simd = _mm_add_ps(_mm_mul_ps(ka, _mm_set1_ps(ao)), ke);
+    __m128 accum[3] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+    for (size_t l = 0; l < count; l++)
+    {
+        const LightSample& s = lights[l];
+        __m128 color = _mm_loadu_ps(s.color);
+        __m128 diffuse = _mm_mul_ps(kd, _mm_mul_ps(_mm_set1_ps(s.dot), color));
+
+        if (s.group == 0)
+        {
+            accum[0] = _mm_add_ps(accum[0], diffuse);
+        }
+        else
+        {
+            __m128 temp = _mm_add_ps(diffuse, _mm_mul_ps(ks, _mm_mul_ps(_mm_set1_ps(s.spec), color)));
+            accum[s.group] = _mm_add_ps(accum[s.group], _mm_mul_ps(temp, _mm_set1_ps(s.factor)));
+        }
+    }
+
+    i_simd = _mm_add_ps(i_simd, accum[0]);
+    i_simd = _mm_add_ps(i_simd, accum[1]);
+    i_simd = _mm_add_ps(i_simd, accum[2]);
+    i_simd = _mm_min_ps(_mm_max_ps(i_simd, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    _mm_storeu_ps(out, i_simd);
+}
+
+R3D_TARGET("sse4.2")
+static bool RasterSpan_SSE42(const float w[3], const float dw[3], int count, int* first, int* last)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 w0 = _mm_set1_ps(w[0]), w1 = _mm_set1_ps(w[1]), w2 = _mm_set1_ps(w[2]);
+    const __m128 d0 = _mm_set1_ps(dw[0]), d1 = _mm_set1_ps(dw[1]), d2 = _mm_set1_ps(dw[2]);
+    int f = -1;
+    int l = -1;
+
+    for (int base = 0; base < count; base += 4)
+    {
+        __m128 k = _mm_add_ps(_mm_set1_ps(static_cast<float>(base)), lane);
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(w0, _mm_mul_ps(k, d0)), zero),
+                                   _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(w1, _mm_mul_ps(k, d1)), zero),
+                                              _mm_cmpge_ps(_mm_add_ps(w2, _mm_mul_ps(k, d2)), zero)));
+        int lanes = std::min(4, count - base);
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_ps(inside)) & ((1u << lanes) - 1u);
+
+        if (mask)
+        {
+            if (f < 0)
+                f = base + LowestBit(mask);
+            l = base + HighestBit(mask);
+            if (HighestBit(mask) < lanes - 1)
+                break;
+        }
+        else if (f >= 0)
+        {
+            break;
+        }
+    }
+
+    if (f < 0)
+        return false;
+
+    *first = f;
+    *last = l;
+    return true;
+}
+
+R3D_TARGET("sse4.2")
+static void LinearizeDepth_SSE42(const float* depth, size_t count, float near, float far, float* out)
+{
+    size_t i = 0;
+    const __m128 num = _mm_set1_ps(2.0f * near * far);
+    const __m128 sum = _mm_set1_ps(far + near);
+    const __m128 diff = _mm_set1_ps(far - near);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 z = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(depth + i), two), one);
+        _mm_storeu_ps(out + i, _mm_div_ps(num, _mm_sub_ps(sum, _mm_mul_ps(z, diff))));
+    }
+
+    LinearizeDepth_Scalar(depth + i, count - i, near, far, out + i);
+}
+
+// ===== AVX2 + FMA (8 voies) =====
+
+R3D_TARGET("avx2,fma")
+static void TransformPositions_AVX2(const float* x, const float* y, const float* z, size_t count, const mat4x4& m,
+                                    float* outX, float* outY, float* outZ, float* outW)
+{
+    size_t i = 0;
+    /*Column-major order : m[colonne][ligne]*/
+    const __m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]), m03 = _mm256_set1_ps(m[0][3]);
+    const __m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]), m13 = _mm256_set1_ps(m[1][3]);
+    const __m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]), m23 = _mm256_set1_ps(m[2][3]);
+    const __m256 m30 = _mm256_set1_ps(m[3][0]), m31 = _mm256_set1_ps(m[3][1]), m32 = _mm256_set1_ps(m[3][2]), m33 = _mm256_set1_ps(m[3][3]);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+
+        _mm256_storeu_ps(outX + i, _mm256_fmadd_ps(vx, m00, _mm256_fmadd_ps(vy, m10, _mm256_fmadd_ps(vz, m20, m30))));
+        _mm256_storeu_ps(outY + i, _mm256_fmadd_ps(vx, m01, _mm256_fmadd_ps(vy, m11, _mm256_fmadd_ps(vz, m21, m31))));
+        _mm256_storeu_ps(outZ + i, _mm256_fmadd_ps(vx, m02, _mm256_fmadd_ps(vy, m12, _mm256_fmadd_ps(vz, m22, m32))));
+        _mm256_storeu_ps(outW + i, _mm256_fmadd_ps(vx, m03, _mm256_fmadd_ps(vy, m13, _mm256_fmadd_ps(vz, m23, m33))));
+    }
+
+    TransformPositions_Scalar(x + i, y + i, z + i, count - i, m, outX + i, outY + i, outZ + i, outW + i);
+}
+
+R3D_TARGET("avx2,fma")
+static void TransformNormals_AVX2(const float* x, const float* y, const float* z, size_t count, const mat3x3& m,
+                                  float* outX, float* outY, float* outZ)
+{
+    size_t i = 0;
+    const __m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]);
+    const __m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]);
+    const __m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+
+        _mm256_storeu_ps(outX + i, _mm256_fmadd_ps(vx, m00, _mm256_fmadd_ps(vy, m10, _mm256_mul_ps(vz, m20))));
+        _mm256_storeu_ps(outY + i, _mm256_fmadd_ps(vx, m01, _mm256_fmadd_ps(vy, m11, _mm256_mul_ps(vz, m21))));
+        _mm256_storeu_ps(outZ + i, _mm256_fmadd_ps(vx, m02, _mm256_fmadd_ps(vy, m12, _mm256_mul_ps(vz, m22))));
+    }
+
+    TransformNormals_Scalar(x + i, y + i, z + i, count - i, m, outX + i, outY + i, outZ + i);
+}
+
+R3D_TARGET("avx2,fma")
+static void ProjectClipToViewport_AVX2(const float* clipX, const float* clipY, const float* clipZ, const float* clipW, size_t count,
+                                       float width, float height, float* screenX, float* screenY, float* screenZ)
+{
+    size_t i = 0;
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 hw = _mm256_set1_ps(width * 0.5f);
+    const __m256 hh = _mm256_set1_ps(height * 0.5f);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 invW = _mm256_div_ps(one, _mm256_loadu_ps(clipW + i));
+        __m256 ndcX = _mm256_mul_ps(_mm256_loadu_ps(clipX + i), invW);
+        __m256 ndcY = _mm256_mul_ps(_mm256_loadu_ps(clipY + i), invW);
+        __m256 ndcZ = _mm256_mul_ps(_mm256_loadu_ps(clipZ + i), invW);
+
+        _mm256_storeu_ps(screenX + i, _mm256_fmadd_ps(ndcX, hw, hw));
+        _mm256_storeu_ps(screenY + i, _mm256_fnmadd_ps(ndcY, hh, hh));
+        _mm256_storeu_ps(screenZ + i, ndcZ);
+    }
+
+    ProjectClipToViewport_Scalar(clipX + i, clipY + i, clipZ + i, clipW + i, count - i, width, height,
+                                 screenX + i, screenY + i, screenZ + i);
+}
+
+R3D_TARGET("avx2,fma")
+static void ShadeLights_FMA(const MaterialTerms& material, float ao, const LightSample* lights, size_t count, float out[4])
+{
+    const __m128 ka = _mm_loadu_ps(material.ka);
+    const __m128 kd = _mm_loadu_ps(material.kd);
+    const __m128 ks = _mm_loadu_ps(material.ks);
+    const __m128 ke = _mm_loadu_ps(material.ke);
+
+    __m128 i_simd = _mm_fmadd_ps(ka, _mm_set1_ps(ao), ke);
+    __m128 accum[3] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+    for (size_t l = 0; l < count; l++)
+    {
+        const LightSample& s = lights[l];
+        __m128 color = _mm_loadu_ps(s.color);
+        __m128 dotColor = _mm_mul_ps(_mm_set1_ps(s.dot), color);
+
+        if (s.group == 0)
+        {
+            accum[0] = _mm_fmadd_ps(kd, dotColor, accum[0]);
+        }
+        else
+        {
+            __m128 temp = _mm_mul_ps(kd, dotColor);
+            temp = _mm_fmadd_ps(ks, _mm_mul_ps(_mm_set1_ps(s.spec), color), temp);
+            accum[s.group] = _mm_fmadd_ps(temp, _mm_set1_ps(s.factor), accum[s.group]);
+        }
+    }
+
+    i_simd = _mm_add_ps(i_simd, accum[0]);
+    i_simd = _mm_add_ps(i_simd, accum[1]);
+    i_simd = _mm_add_ps(i_simd, accum[2]);
+    i_simd = _mm_min_ps(_mm_max_ps(i_simd, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    _mm_storeu_ps(out, i_simd);
+}
+
+R3D_TARGET("avx2,fma")
+static bool RasterSpan_AVX2(const float w[3], const float dw[3], int count, int* first, int* last)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 w0 = _mm256_set1_ps(w[0]), w1 = _mm256_set1_ps(w[1]), w2 = _mm256_set1_ps(w[2]);
+    const __m256 d0 = _mm256_set1_ps(dw[0]), d1 = _mm256_set1_ps(dw[1]), d2 = _mm256_set1_ps(dw[2]);
+    int f = -1;
+    int l = -1;
+
+    for (int base = 0; base < count; base += 8)
+    {
+        __m256 k = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(base)), lane);
+        __m256 inside = _mm256_and_ps(_mm256_cmp_ps(_mm256_fmadd_ps(k, d0, w0), zero, _CMP_GE_OQ),
+                                      _mm256_and_ps(_mm256_cmp_ps(_mm256_fmadd_ps(k, d1, w1), zero, _CMP_GE_OQ),
+                                                    _mm256_cmp_ps(_mm256_fmadd_ps(k, d2, w2), zero, _CMP_GE_OQ)));
+        int lanes = std::min(8, count - base);
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_ps(inside)) & ((1u << lanes) - 1u);
+
+        if (mask)
+        {
+            if (f < 0)
+                f = base + LowestBit(mask);
+            l = base + HighestBit(mask);
+            if (HighestBit(mask) < lanes - 1)
+                break;
+        }
+        else if (f >= 0)
+        {
+            break;
+        }
+    }
+
+    if (f < 0)
+        return false;
+
+    *first = f;
+    *last = l;
+    return true;
+}
+
+// Pas de FMA ici : l'aire doit être identique à celle de ComputeEdgeFunction côté rasterisation.
+R3D_TARGET("avx2")
+static size_t TriangleSetup_AVX2(const TriangleSetupInput& in, size_t count, SetupTriangle* out, int* clipList, size_t* clipCount)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 maxX = _mm256_set1_ps(in.width - 1.0f);
+    const __m256 maxY = _mm256_set1_ps(in.height - 1.0f);
+    const __m256 guardMinX = _mm256_set1_ps((1.0f - in.guardBand) * in.width * 0.5f);
+    const __m256 guardMaxX = _mm256_set1_ps((1.0f + in.guardBand) * in.width * 0.5f);
+    const __m256 guardMinY = _mm256_set1_ps((1.0f - in.guardBand) * in.height * 0.5f);
+    const __m256 guardMaxY = _mm256_set1_ps((1.0f + in.guardBand) * in.height * 0.5f);
+    size_t survivors = 0;
+    *clipCount = 0;
+
+    alignas(32) int ia[8], ib[8], ic[8], code[8];
+    alignas(32) float area[8], stepX[3][8], invW[3][8];
+    alignas(32) int x0[8], x1[8], y0[8], y1[8];
+
+    for (size_t base = 0; base < count; base += 8)
+    {
+        const int lanes = static_cast<int>(std::min<size_t>(8, count - base));
+        unsigned int nearMask = 0;
+
+        // Désentrelacement des indices et codes de sortie ; les voies inutilisées pointent sur le vertex 0.
+        for (int l = 0; l < 8; l++)
+        {
+            if (l < lanes)
+            {
+                const uint32_t* tri = in.indices + 3 * (base + l);
+                ia[l] = static_cast<int>(tri[0]);
+                ib[l] = static_cast<int>(tri[1]);
+                ic[l] = static_cast<int>(tri[2]);
+                code[l] = in.outcodes[ia[l]] & in.outcodes[ib[l]] & in.outcodes[ic[l]];
+                if (code[l] == 0 && ((in.outcodes[ia[l]] | in.outcodes[ib[l]] | in.outcodes[ic[l]]) & in.clipMask))
+                {
+                    // Traverse le plan near : projection invalide, la voie part au découpage.
+                    nearMask |= 1u << l;
+                    code[l] = 1;
+                }
+            }
+            else
+            {
+                ia[l] = ib[l] = ic[l] = 0;
+                code[l] = 1;
+            }
+        }
+
+        const __m256i va = _mm256_load_si256(reinterpret_cast<const __m256i*>(ia));
+        const __m256i vb = _mm256_load_si256(reinterpret_cast<const __m256i*>(ib));
+        const __m256i vc = _mm256_load_si256(reinterpret_cast<const __m256i*>(ic));
+
+        const __m256 ax = _mm256_i32gather_ps(in.screenX, va, 4), ay = _mm256_i32gather_ps(in.screenY, va, 4);
+        const __m256 bx = _mm256_i32gather_ps(in.screenX, vb, 4), by = _mm256_i32gather_ps(in.screenY, vb, 4);
+        const __m256 cx = _mm256_i32gather_ps(in.screenX, vc, 4), cy = _mm256_i32gather_ps(in.screenY, vc, 4);
+
+        const __m256 vArea = _mm256_sub_ps(_mm256_mul_ps(_mm256_sub_ps(cx, ax), _mm256_sub_ps(by, ay)),
+                                           _mm256_mul_ps(_mm256_sub_ps(cy, ay), _mm256_sub_ps(bx, ax)));
+
+        const __m256 xMin = _mm256_min_ps(ax, _mm256_min_ps(bx, cx));
+        const __m256 xMax = _mm256_max_ps(ax, _mm256_max_ps(bx, cx));
+        const __m256 yMin = _mm256_min_ps(ay, _mm256_min_ps(by, cy));
+        const __m256 yMax = _mm256_max_ps(ay, _mm256_max_ps(by, cy));
+
+        __m256 keep = _mm256_cmp_ps(vArea, zero, _CMP_GT_OQ);
+        keep = _mm256_and_ps(keep, _mm256_cmp_ps(xMin, maxX, _CMP_NGT_UQ));
+        keep = _mm256_and_ps(keep, _mm256_cmp_ps(xMax, zero, _CMP_NLT_UQ));
+        keep = _mm256_and_ps(keep, _mm256_cmp_ps(yMin, maxY, _CMP_NGT_UQ));
+        keep = _mm256_and_ps(keep, _mm256_cmp_ps(yMax, zero, _CMP_NLT_UQ));
+        keep = _mm256_and_ps(keep, _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(code)),
+                                                                          _mm256_setzero_si256())));
+
+        const __m256 outsideGuard = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(xMin, guardMinX, _CMP_LT_OQ), _mm256_cmp_ps(xMax, guardMaxX, _CMP_GT_OQ)),
+                                                 _mm256_or_ps(_mm256_cmp_ps(yMin, guardMinY, _CMP_LT_OQ), _mm256_cmp_ps(yMax, guardMaxY, _CMP_GT_OQ)));
+
+        unsigned int clipMask = nearMask | static_cast<unsigned int>(_mm256_movemask_ps(_mm256_and_ps(keep, outsideGuard)));
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_andnot_ps(outsideGuard, keep)));
+
+        while (clipMask)
+        {
+            clipList[(*clipCount)++] = static_cast<int>(base) + LowestBit(clipMask);
+            clipMask &= clipMask - 1;
+        }
+
+        if (mask == 0)
+            continue;
+
+        _mm256_store_ps(area, vArea);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(x0), _mm256_cvttps_epi32(_mm256_max_ps(zero, xMin)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(x1), _mm256_cvttps_epi32(_mm256_min_ps(xMax, maxX)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(y0), _mm256_cvttps_epi32(_mm256_max_ps(zero, yMin)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(y1), _mm256_cvttps_epi32(_mm256_min_ps(yMax, maxY)));
+        _mm256_store_ps(stepX[0], _mm256_sub_ps(cy, by));
+        _mm256_store_ps(stepX[1], _mm256_sub_ps(ay, cy));
+        _mm256_store_ps(stepX[2], _mm256_sub_ps(by, ay));
+        _mm256_store_ps(invW[0], _mm256_div_ps(one, _mm256_i32gather_ps(in.clipW, va, 4)));
+        _mm256_store_ps(invW[1], _mm256_div_ps(one, _mm256_i32gather_ps(in.clipW, vb, 4)));
+        _mm256_store_ps(invW[2], _mm256_div_ps(one, _mm256_i32gather_ps(in.clipW, vc, 4)));
+
+        // Compaction des survivants.
+        while (mask)
+        {
+            const int l = LowestBit(mask);
+            mask &= mask - 1;
+
+            SetupTriangle& s = out[survivors++];
+            s.index = static_cast<int>(base) + l;
+            s.area = area[l];
+            s.x0 = x0[l];
+            s.x1 = x1[l];
+            s.y0 = y0[l];
+            s.y1 = y1[l];
+            for (int e = 0; e < 3; e++)
+            {
+                s.stepX[e] = stepX[e][l];
+                s.invW[e] = invW[e][l];
+            }
+            s.clipped = false;
+        }
+    }
+
+    return survivors;
+}
+
+R3D_TARGET("avx2,fma")
+static void LinearizeDepth_AVX2(const float* depth, size_t count, float near, float far, float* out)
+{
+    size_t i = 0;
+    const __m256 num = _mm256_set1_ps(2.0f * near * far);
+    const __m256 sum = _mm256_set1_ps(far + near);
+    const __m256 diff = _mm256_set1_ps(far - near);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 z = _mm256_fmsub_ps(_mm256_loadu_ps(depth + i), two, one);
+        _mm256_storeu_ps(out + i, _mm256_div_ps(num, _mm256_fnmadd_ps(z, diff, sum)));
+    }
+
+    LinearizeDepth_Scalar(depth + i, count - i, near, far, out + i);
+}
+
+// ===== AVX-512F (16 voies) =====
+
+R3D_TARGET("avx512f,avx2,fma")
+static void TransformPositions_AVX512(const float* x, const float* y, const float* z, size_t count, const mat4x4& m,
+                                      float* outX, float* outY, float* outZ, float* outW)
+{
+    size_t i = 0;
+    __m512 col[4][4];
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            col[c][r] = _mm512_set1_ps(m[c][r]);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 vx = _mm512_loadu_ps(x + i);
+        __m512 vy = _mm512_loadu_ps(y + i);
+        __m512 vz = _mm512_loadu_ps(z + i);
+        float* outs[4] = {outX, outY, outZ, outW};
+
+        for (int r = 0; r < 4; r++)
+            _mm512_storeu_ps(outs[r] + i, _mm512_fmadd_ps(vx, col[0][r], _mm512_fmadd_ps(vy, col[1][r], _mm512_fmadd_ps(vz, col[2][r], col[3][r]))));
+    }
+
+    TransformPositions_AVX2(x + i, y + i, z + i, count - i, m, outX + i, outY + i, outZ + i, outW + i);
+}
+
+R3D_TARGET("avx512f,avx2,fma")
+static void TransformNormals_AVX512(const float* x, const float* y, const float* z, size_t count, const mat3x3& m,
+                                    float* outX, float* outY, float* outZ)
+{
+    size_t i = 0;
+    __m512 col[3][3];
+    for (int c = 0; c < 3; c++)
+        for (int r = 0; r < 3; r++)
+            col[c][r] = _mm512_set1_ps(m[c][r]);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 vx = _mm512_loadu_ps(x + i);
+        __m512 vy = _mm512_loadu_ps(y + i);
+        __m512 vz = _mm512_loadu_ps(z + i);
+        float* outs[3] = {outX, outY, outZ};
+
+        for (int r = 0; r < 3; r++)
+            _mm512_storeu_ps(outs[r] + i, _mm512_fmadd_ps(vx, col[0][r], _mm512_fmadd_ps(vy, col[1][r], _mm512_mul_ps(vz, col[2][r]))));
+    }
+
+    TransformNormals_AVX2(x + i, y + i, z + i, count - i, m, outX + i, outY + i, outZ + i);
+}
+
+R3D_TARGET("avx512f,avx2,fma")
+static void ProjectClipToViewport_AVX512(const float* clipX, const float* clipY, const float* clipZ, const float* clipW, size_t count,
+                                         float width, float height, float* screenX, float* screenY, float* screenZ)
+{
+    size_t i = 0;
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 hw = _mm512_set1_ps(width * 0.5f);
+    const __m512 hh = _mm512_set1_ps(height * 0.5f);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 invW = _mm512_div_ps(one, _mm512_loadu_ps(clipW + i));
+        __m512 ndcX = _mm512_mul_ps(_mm512_loadu_ps(clipX + i), invW);
+        __m512 ndcY = _mm512_mul_ps(_mm512_loadu_ps(clipY + i), invW);
+        __m512 ndcZ = _mm512_mul_ps(_mm512_loadu_ps(clipZ + i), invW);
+
+        _mm512_storeu_ps(screenX + i, _mm512_fmadd_ps(ndcX, hw, hw));
+        _mm512_storeu_ps(screenY + i, _mm512_fnmadd_ps(ndcY, hh, hh));
+        _mm512_storeu_ps(screenZ + i, ndcZ);
+    }
+
+    ProjectClipToViewport_AVX2(clipX + i, clipY + i, clipZ + i, clipW + i, count - i, width, height,
+                               screenX + i, screenY + i, screenZ + i);
+}
+
+R3D_TARGET("avx512f,avx2,fma")
+static void LinearizeDepth_AVX512(const float* depth, size_t count, float near, float far, float* out)
+{
+    size_t i = 0;
+    const __m512 num = _mm512_set1_ps(2.0f * near * far);
+    const __m512 sum = _mm512_set1_ps(far + near);
+    const __m512 diff = _mm512_set1_ps(far - near);
+    const __m512 two = _mm512_set1_ps(2.0f);
+    const __m512 one = _mm512_set1_ps(1.0f);
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512 z = _mm512_fmsub_ps(_mm512_loadu_ps(depth + i), two, one);
+        _mm512_storeu_ps(out + i, _mm512_div_ps(num, _mm512_fnmadd_ps(z, diff, sum)));
+    }
+
+    LinearizeDepth_AVX2(depth + i, count - i, near, far, out + i);
+}
+
+#endif // R3D_X86
+
+// ===== Sélection au démarrage =====
+
+const char* SimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::SSE42:
+        return "SSE4.2";
+    case SimdLevel::AVX2:
+        return "AVX2+FMA";
+    case SimdLevel::AVX512:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
+
+static SimdLevel DetectSimdLevel()
+{
+    SimdLevel level = SimdLevel::Scalar;
+
+#ifdef R3D_X86
+    const CpuFeatures& cpu = GetCpuFeatures();
+    if (cpu.sse42)
+        level = SimdLevel::SSE42;
+    if (cpu.sse42 && cpu.avx2 && cpu.fma)
+        level = SimdLevel::AVX2;
+    if (level == SimdLevel::AVX2 && cpu.avx512f)
+        level = SimdLevel::AVX512;
+#endif
+
+    // Un niveau forcé ne peut qu'abaisser celui détecté.
+    const char* forced = std::getenv("R3D_SIMD");
+    if (forced != nullptr)
+    {
+        SimdLevel requested = level;
+        if (std::strcmp(forced, "scalar") == 0)
+            requested = SimdLevel::Scalar;
+        else if (std::strcmp(forced, "sse42") == 0)
+            requested = SimdLevel::SSE42;
+        else if (std::strcmp(forced, "avx2") == 0)
+            requested = SimdLevel::AVX2;
+        else if (std::strcmp(forced, "avx512") == 0)
+            requested = SimdLevel::AVX512;
+
+        if (static_cast<int>(requested) < static_cast<int>(level))
+            level = requested;
+    }
+
+    return level;
+}
+
+static SimdKernels BindSimdKernels(SimdLevel level)
+{
+    SimdKernels k;
+    k.level = SimdLevel::Scalar;
+    k.transformPositions = TransformPositions_Scalar;
+    k.transformNormals = TransformNormals_Scalar;
+    k.projectClipToViewport = ProjectClipToViewport_Scalar;
+    k.shadeLights = ShadeLights_Scalar;
+    k.rasterSpan = RasterSpan_Scalar;
+    k.triangleSetup = TriangleSetup_Scalar;
+    k.linearizeDepth = LinearizeDepth_Scalar;
+
+#ifdef R3D_X86
+    switch (level)
+    {
+    case SimdLevel::AVX512:
+        k.level = SimdLevel::AVX512;
+        k.transformPositions = TransformPositions_AVX512;
+        k.transformNormals = TransformNormals_AVX512;
+        k.projectClipToViewport = ProjectClipToViewport_AVX512;
+        k.shadeLights = ShadeLights_FMA;
+        k.rasterSpan = RasterSpan_AVX2;
+        k.triangleSetup = TriangleSetup_AVX2;
+        k.linearizeDepth = LinearizeDepth_AVX512;
+        break;
+    case SimdLevel::AVX2:
+        k.level = SimdLevel::AVX2;
+        k.transformPositions = TransformPositions_AVX2;
+        k.transformNormals = TransformNormals_AVX2;
+        k.projectClipToViewport = ProjectClipToViewport_AVX2;
+        k.shadeLights = ShadeLights_FMA;
+        k.rasterSpan = RasterSpan_AVX2;
+        k.triangleSetup = TriangleSetup_AVX2;
+        k.linearizeDepth = LinearizeDepth_AVX2;
+        break;
+    case SimdLevel::SSE42:
+        k.level = SimdLevel::SSE42;
+        k.transformPositions = TransformPositions_SSE42;
+        k.transformNormals = TransformNormals_SSE42;
+        k.projectClipToViewport = ProjectClipToViewport_SSE42;
+        k.shadeLights = ShadeLights_SSE42;
+        k.rasterSpan = RasterSpan_SSE42;
+        k.linearizeDepth = LinearizeDepth_SSE42;
+        break;
+    default:
+        break;
+    }
+#else
+    (void)level;
+#endif
+
+    return k;
+}
+
+const SimdKernels& GetSimdKernels()
+{
+    static const SimdKernels kernels = BindSimdKernels(DetectSimdLevel());
+    return kernels;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm.hpp>
+
+using namespace glm;
+
+// Niveau d'instructions retenu au démarrage pour les noyaux SIMD.
+enum class SimdLevel
+{
+    Scalar,
+    SSE42,
+    AVX2, // AVX2 + FMA
+    AVX512
+};
+
+const char* SimdLevelName(SimdLevel level);
+
+// Contribution d'une lumière déjà évaluée (dot, spéculaire, atténuation/spot) au point éclairé.
+// group : 0 = directionnelle (diffus seul), 1 = ponctuelle, 2 = spot.
+struct LightSample
+{
+    float color[4];
+    float dot;
+    float spec;
+    float factor;
+    int group;
+};
+
+// Coefficients Ka/Kd/Ks/Ke du matériau, alignés sur 4 flottants.
+struct MaterialTerms
+{
+    float ka[4];
+    float kd[4];
+    float ks[4];
+    float ke[4];
+};
+
+// Entrée du setup de triangles : sommets d'un objet déjà projetés à l'écran (SoA), leur w clip,
+// leurs codes de sortie du frustum, et 3 indices de vertex par triangle.
+struct TriangleSetupInput
+{
+    const float* screenX;
+    const float* screenY;
+    const float* clipW;
+    const unsigned char* outcodes;
+    const uint32_t* indices;
+    float width;
+    float height;
+    unsigned char clipMask; // bits de code de sortie imposant un découpage (plan near)
+    float guardBand;        // demi-largeur de la bande de garde en NDC
+};
+
+// Triangle ayant survécu au setup, avec ses coefficients de rasterisation.
+struct SetupTriangle
+{
+    int index;          // numéro du triangle dans l'entrée
+    float area;         // aire signée écran, > 0 pour une face avant
+    int x0, y0, x1, y1; // boîte englobante bornée à l'écran
+    float stepX[3];     // incrément des trois fonctions d'arête pour un pixel en x
+    float invW[3];      // 1 / w des sommets, pour l'interpolation perspective
+    bool clipped;       // sous-triangle issu du découpage d'une face
+    float bary[3][3];   // si clipped : barycentriques de chaque sommet dans la face d'origine
+};
+
+typedef void (*TransformPositionsFn)(const float* x, const float* y, const float* z, size_t count, const mat4x4& m,
+                                     float* outX, float* outY, float* outZ, float* outW);
+typedef void (*TransformNormalsFn)(const float* x, const float* y, const float* z, size_t count, const mat3x3& m,
+                                   float* outX, float* outY, float* outZ);
+typedef void (*ProjectClipToViewportFn)(const float* clipX, const float* clipY, const float* clipZ, const float* clipW, size_t count,
+                                        float width, float height, float* screenX, float* screenY, float* screenZ);
+// Somme Ka*ao + Ke + contributions des lumières, bornée dans [0, 1].
+typedef void (*ShadeLightsFn)(const MaterialTerms& material, float ao, const LightSample* lights, size_t count, float out[4]);
+// Cherche sur une ligne de "count" pixels l'intervalle [first, last] où les trois fonctions d'arête
+// w[i] + k * dw[i] sont positives. Renvoie false si la ligne ne couvre aucun pixel.
+typedef bool (*RasterSpanFn)(const float w[3], const float dw[3], int count, int* first, int* last);
+// Setup de "count" triangles : rejette les faces arrière (aire signée <= 0), hors frustum (codes de sortie
+// communs aux trois sommets) ou hors écran, et écrit les survivants compactés dans out. Renvoie leur nombre.
+// Les triangles qui traversent le plan near ou sortent de la bande de garde sont listés dans clipList.
+typedef size_t (*TriangleSetupFn)(const TriangleSetupInput& in, size_t count, SetupTriangle* out, int* clipList, size_t* clipCount);
+// Convertit un buffer de profondeur [0, 1] en profondeur linéaire (même formule que LinearizeDepth du SSR).
+typedef void (*LinearizeDepthFn)(const float* depth, size_t count, float near, float far, float* out);
+
+// Table des noyaux, liée une seule fois à la meilleure implémentation supportée par le processeur.
+struct SimdKernels
+{
+    SimdLevel level;
+    TransformPositionsFn transformPositions;
+    TransformNormalsFn transformNormals;
+    ProjectClipToViewportFn projectClipToViewport;
+    ShadeLightsFn shadeLights;
+    RasterSpanFn rasterSpan;
+    TriangleSetupFn triangleSetup;
+    LinearizeDepthFn linearizeDepth;
+};
+
+// Détecte les extensions CPU au premier appel et renvoie la table correspondante.
+// La variable d'environnement R3D_SIMD (scalar, sse42, avx2, avx512) permet de forcer un niveau inférieur.
+const SimdKernels& GetSimdKernels();
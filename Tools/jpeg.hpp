@@ -2,61 +2,127 @@
 #include <cstdio>
 #include <jpeglib.h>
 #include <cstdlib>
+#include "MappedFile.hpp"
 
-inline bool readJPEG(const char* filename, unsigned char*& img, int& width, int& height) {
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-
-    // Ouvrir le fichier JPEG
-    FILE* infile;
+// Entrée d'un fichier JPEG pour libjpeg : FILE* sous Windows et macOS ; ailleurs (Linux), fichier
+// projeté en mémoire et lu par jpeg_mem_src, sans tampon stdio ni copie.
+class JpegInput {
+public:
+    // populate : le fichier sera décodé en entier, toutes ses pages sont lues dès la projection.
+    JpegInput(const char* filename, bool populate) {
     #if defined(_WIN32)
-        errno_t err = fopen_s(&infile, filename, "rb");
-        if (err != 0 || infile == NULL) {
+        errno_t err = fopen_s(&_file, filename, "rb");
+        if (err != 0 || _file == NULL) {
             printf("Erreur d'ouverture du fichier JPEG %s\n",filename);
-            return false;
+            _file = NULL;
         }
     #elif defined(__APPLE__)
-        infile = fopen(filename, "rb");
-        if (infile == NULL) {
+        (void)populate;
+        _file = fopen(filename, "rb");
+        if (_file == NULL) {
+            printf("Erreur d'ouverture du fichier JPEG: %s\n",filename);
+        }
+    #else
+        if (!_file.open(filename, populate) || _file.size() == 0) {
             printf("Erreur d'ouverture du fichier JPEG: %s\n",filename);
-            return false;
+            _file.close();
         }
     #endif
-    
+    }
+
+    ~JpegInput() {
+    #if defined(_WIN32) || defined(__APPLE__)
+        if (_file != NULL)
+            fclose(_file);
+    #endif
+    }
+
+    JpegInput(const JpegInput&) = delete;
+    JpegInput& operator=(const JpegInput&) = delete;
+
+    bool is_open() const {
+    #if defined(_WIN32) || defined(__APPLE__)
+        return _file != NULL;
+    #else
+        return _file.is_open();
+    #endif
+    }
+
+    void attach(jpeg_decompress_struct& cinfo) {
+    #if defined(_WIN32) || defined(__APPLE__)
+        jpeg_stdio_src(&cinfo, _file);
+    #else
+        jpeg_mem_src(&cinfo, reinterpret_cast<unsigned char*>(const_cast<char*>(_file.data())), static_cast<unsigned long>(_file.size()));
+    #endif
+    }
+
+private:
+#if defined(_WIN32) || defined(__APPLE__)
+    FILE* _file = NULL;
+#else
+    MappedFile _file;
+#endif
+};
+
+// Lit seulement l'en-tête d'un fichier JPEG : dimensions de l'image à pleine résolution.
+inline bool readJPEGSize(const char* filename, int& width, int& height) {
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    JpegInput input(filename, false);
+    if (!input.is_open())
+        return false;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    input.attach(cinfo);
+    (void)jpeg_read_header(&cinfo, TRUE);
+
+    width = cinfo.image_width;
+    height = cinfo.image_height;
+
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+// Décode un fichier JPEG en RGB, lignes rangées de bas en haut.
+// scaleDenom (1, 2, 4 ou 8) réduit la résolution dans l'IDCT de libjpeg : l'essentiel du travail est évité.
+inline bool readJPEG(const char* filename, unsigned char*& img, int& width, int& height, int scaleDenom = 1) {
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    // Ouvrir le fichier JPEG
+    JpegInput input(filename, true);
+    if (!input.is_open())
+        return false;
+
     // Initialiser le décodeur JPEG
     cinfo.err = jpeg_std_error(&jerr);
     jpeg_create_decompress(&cinfo);
-    jpeg_stdio_src(&cinfo, infile);
+    input.attach(cinfo);
 
     // Lire l'en-tête du fichier JPEG
     (void)jpeg_read_header(&cinfo, TRUE);
 
     cinfo.out_color_space = JCS_RGB;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = scaleDenom;
 
     // Commencer la décompression
     (void)jpeg_start_decompress(&cinfo);
 
-    // Allouer la mémoire pour stocker une ligne de pixels
-    JSAMPARRAY buffer;
-    buffer = (*cinfo.mem->alloc_sarray)
-        ((j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.output_width * cinfo.output_components, 1);
+    // Chaque ligne est décodée directement à sa place dans l'image retournée verticalement,
+    // par groupes de lignes (libjpeg en produit jusqu'à rec_outbuf_height par appel).
+    const size_t stride = static_cast<size_t>(cinfo.output_width) * cinfo.output_components;
+    img = new unsigned char[stride * cinfo.output_height];
 
-    // Lire chaque ligne de l'image et la stocker dans un tableau unidimensionnel
-    img = new unsigned char[cinfo.output_width * cinfo.output_height * cinfo.output_components];
-    
+    const JDIMENSION maxRows = 16;
+    JSAMPROW rows[maxRows];
     while (cinfo.output_scanline < cinfo.output_height) {
-        (void)jpeg_read_scanlines(&cinfo, buffer, 1);
-        
-        // Calculer l'index de la ligne (inversée ou non)
-      /*  int row = flipVertical ? 
-            (cinfo.output_height - cinfo.output_scanline) : 
-            (cinfo.output_scanline - 1);*/
-
-        int row =  (cinfo.output_height - cinfo.output_scanline);
-        
-        for (JDIMENSION i = 0; i < cinfo.output_width * cinfo.output_components; i++) {
-            img[row * cinfo.output_width * cinfo.output_components + i] = buffer[0][i];
-        }
+        const JDIMENSION count = cinfo.output_height - cinfo.output_scanline < maxRows ? cinfo.output_height - cinfo.output_scanline : maxRows;
+        for (JDIMENSION i = 0; i < count; i++)
+            rows[i] = img + (cinfo.output_height - 1 - cinfo.output_scanline - i) * stride;
+        (void)jpeg_read_scanlines(&cinfo, rows, count);
     }
 
     // Stocker la largeur et la hauteur de l'image
@@ -66,8 +132,62 @@ inline bool readJPEG(const char* filename, unsigned char*& img, int& width, int&
     // Terminer la décompression et libérer les ressources
     (void)jpeg_finish_decompress(&cinfo);
     jpeg_destroy_decompress(&cinfo);
-    fclose(infile);
 
     // Retourner true pour indiquer que l'opération a réussi
     return true;
 }
+
+// Décode un fichier JPEG en RGB par groupes de lignes, de haut en bas, sans jamais garder l'image entière
+// (textures virtuelles : seules quelques lignes d'une texture de 16K sont en mémoire à la fois).
+class JpegRowReader {
+public:
+    explicit JpegRowReader(const char* filename) : _input(filename, false) {
+        if (!_input.is_open())
+            return;
+        _cinfo.err = jpeg_std_error(&_jerr);
+        jpeg_create_decompress(&_cinfo);
+        _input.attach(_cinfo);
+        (void)jpeg_read_header(&_cinfo, TRUE);
+        _cinfo.out_color_space = JCS_RGB;
+        (void)jpeg_start_decompress(&_cinfo);
+        _started = true;
+    }
+
+    ~JpegRowReader() {
+        if (!_started)
+            return;
+        // Lecture interrompue avant la dernière ligne : jpeg_finish_decompress exigerait toutes les lignes.
+        if (_cinfo.output_scanline < _cinfo.output_height)
+            jpeg_abort_decompress(&_cinfo);
+        else
+            (void)jpeg_finish_decompress(&_cinfo);
+        jpeg_destroy_decompress(&_cinfo);
+    }
+
+    JpegRowReader(const JpegRowReader&) = delete;
+    JpegRowReader& operator=(const JpegRowReader&) = delete;
+
+    bool is_open() const { return _started; }
+    int width() const { return _started ? static_cast<int>(_cinfo.output_width) : 0; }
+    int height() const { return _started ? static_cast<int>(_cinfo.output_height) : 0; }
+
+    // Décode les count lignes suivantes, rangées à la suite dans rows (3 octets par texel) ; renvoie le nombre lu.
+    int readRows(unsigned char* rows, int count) {
+        const size_t stride = static_cast<size_t>(_cinfo.output_width) * 3;
+        int read = 0;
+        while (read < count && _cinfo.output_scanline < _cinfo.output_height) {
+            JSAMPROW pointers[16];
+            const int n = count - read < 16 ? count - read : 16;
+            for (int i = 0; i < n; i++)
+                pointers[i] = rows + (read + i) * stride;
+            read += static_cast<int>(jpeg_read_scanlines(&_cinfo, pointers, n));
+        }
+        return read;
+    }
+
+private:
+    JpegInput _input;
+    struct jpeg_decompress_struct _cinfo;
+    struct jpeg_error_mgr _jerr;
+    bool _started = false;
+};